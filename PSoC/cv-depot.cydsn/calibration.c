@@ -107,8 +107,8 @@ uint16_t BendToReference(int16_t initial_bend)
 void ChangeWiper(pot_t *pot, uint16_t wiper)
 {
     LED_Driver_Write7SegNumberDec(wiper, 1, 2, LED_Driver_RIGHT_ALIGN);
-    PotSetTargetPosition(pot, wiper);
-    while (!PotUpdate(pot)) {}
+    PotChangePlaceRequest(pot, wiper);
+    while (!PotChangeIsSettled(pot)) {}
 }
 
 struct calib_config {
@@ -190,7 +190,7 @@ void CalibrateNoteCV(struct calib_config *config, uint16_t bend_octave_width)
     ChangeWiper(config->pot, low);
 
     // save the wiper position
-    EEPROM_WriteByte(config->pot->current, config->save_address);
+    Save8(config->pot->current, config->save_address);
 
     CyDelay(950);
 }
@@ -199,6 +199,8 @@ void Calibrate()
 {
     // turn off portament
     Pin_Portament_En_Write(0);
+    // take over the bend PWM
+    SuspendBendDriver();
 
     mode = MODE_CALIBRATION_INIT;
     RED_ENCODER_LED_ON();
@@ -249,6 +251,7 @@ void Calibrate()
     // wrap up
     bend_offset = BEND_STEPS / 2;
     PWM_Bend_WriteCompare(bend_offset);
+    ResumeBendDriver();
     Pin_Adj_En_Write(0);
     Pin_Encoder_LED_1_Write(0);
     Pin_Encoder_LED_2_Write(0);
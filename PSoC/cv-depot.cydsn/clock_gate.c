@@ -0,0 +1,172 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2025 Naoki Iwakami
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "project.h"
+
+#include "clock_gate.h"
+#include "eeprom.h"
+#include "hardware.h"
+#include "main.h"
+#include "midi_clock.h"
+
+// Pulses are 5ms long, or a half of the clock period if shorter
+#define PULSE_WIDTH_TICKS 234
+
+#define TIME_REACHED(time) ((int32_t)(timer_counter - (time)) >= 0)
+
+// Pulse edges
+#define PULSE_RISE 0x01
+#define PULSE_FALL 0x02
+
+// The rise of the next pulse is scheduled while the current pulse is still high,
+// so the edges have their own times.
+typedef struct pulse {
+    volatile uint8_t pending;  // armed edges
+    uint32_t rise_time;
+    uint32_t fall_time;
+    uint32_t armed_index;      // clock index of the scheduled rise
+} pulse_t;
+
+uint8_t gate_outputs[NUM_VOICES];
+
+static pulse_t pulses[NUM_VOICES];
+
+// MIDI clocks per pulse
+static const uint8_t kDivisions[GATE_OUTPUT_END] = { 0, 1, 24, 12, 6, 8, 4, 0 };
+
+void InitializeClockGates()
+{
+    for (uint8_t i = 0; i < NUM_VOICES; ++i) {
+        gate_outputs[i] = ReadEepromWithValueCheck(ADDR_GATE_OUTPUTS + i, GATE_OUTPUT_END);
+        pulses[i].pending = 0;
+        pulses[i].armed_index = 0xffffffff;
+    }
+}
+
+int8_t UpdateGateOutput(enum Voice voice, enum GateOutput new_gate_output, uint8_t save)
+{
+    if (new_gate_output == gate_outputs[voice]) {
+        // no change, do nothing
+        return 0;
+    }
+    if (save) {
+        Save8(new_gate_output, ADDR_GATE_OUTPUTS + voice);
+    }
+    uint8_t state = CyEnterCriticalSection();
+    gate_outputs[voice] = new_gate_output;
+    pulses[voice].pending = 0;
+    CyExitCriticalSection(state);
+    SetClockGate(voice, 0);
+    return 1;
+}
+
+static uint32_t PulseWidth()
+{
+    uint32_t width = midi_clock.period >> 9;  // a half of the period
+    return width == 0 || width > PULSE_WIDTH_TICKS ? PULSE_WIDTH_TICKS : width;
+}
+
+static void StartPulse(enum Voice voice, uint32_t now)
+{
+    pulse_t *pulse = &pulses[voice];
+    uint8_t state = CyEnterCriticalSection();
+    pulse->pending &= ~PULSE_RISE;
+    pulse->fall_time = now + PulseWidth();
+    pulse->pending |= PULSE_FALL;
+    SetClockGate(voice, 1);
+    CyExitCriticalSection(state);
+}
+
+static void SchedulePulse(enum Voice voice, uint32_t time, uint32_t index)
+{
+    pulse_t *pulse = &pulses[voice];
+    uint8_t state = CyEnterCriticalSection();
+    pulse->rise_time = time;
+    pulse->armed_index = index;
+    pulse->pending |= PULSE_RISE;
+    CyExitCriticalSection(state);
+}
+
+void ClockGateHandleClock(uint32_t index, uint32_t now)
+{
+    // time of the next clock by the tracker
+    uint32_t next = now + ((int32_t)(midi_clock.predicted - (now << 8)) >> 8);
+    for (uint8_t i = 0; i < NUM_VOICES; ++i) {
+        uint8_t division = kDivisions[gate_outputs[i]];
+        if (division == 0) {
+            continue;
+        }
+        pulse_t *pulse = &pulses[i];
+        if (index % division == 0) {
+            // not predicted, e.g., the first clock after the start, or earlier than predicted
+            if (pulse->armed_index != index || (pulse->pending & PULSE_RISE)) {
+                StartPulse(i, now);
+            }
+        }
+        if (midi_clock.locked && (index + 1) % division == 0) {
+            SchedulePulse(i, next, index + 1);
+        }
+    }
+}
+
+void ClockGateHandleStop()
+{
+    for (uint8_t i = 0; i < NUM_VOICES; ++i) {
+        uint8_t state = CyEnterCriticalSection();
+        pulses[i].pending &= ~PULSE_RISE;
+        pulses[i].armed_index = 0xffffffff;
+        CyExitCriticalSection(state);
+    }
+}
+
+void ClockGateHandleStart(uint32_t now)
+{
+    ClockGateHandleStop();
+    for (uint8_t i = 0; i < NUM_VOICES; ++i) {
+        if (gate_outputs[i] == GATE_OUTPUT_START) {
+            StartPulse(i, now);
+        }
+    }
+}
+
+void ClockGateHandleTick()
+{
+    for (uint8_t i = 0; i < NUM_VOICES; ++i) {
+        pulse_t *pulse = &pulses[i];
+        if (pulse->pending == 0) {
+            continue;
+        }
+        if ((pulse->pending & PULSE_FALL) && TIME_REACHED(pulse->fall_time)) {
+            SetClockGate(i, 0);
+            pulse->pending &= ~PULSE_FALL;
+        }
+        if ((pulse->pending & PULSE_RISE) && TIME_REACHED(pulse->rise_time)) {
+            SetClockGate(i, 1);
+            pulse->fall_time = pulse->rise_time + PulseWidth();
+            pulse->pending = PULSE_FALL;
+        }
+    }
+}
+
+/* [] END OF FILE */
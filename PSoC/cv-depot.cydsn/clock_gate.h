@@ -0,0 +1,93 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2025 Naoki Iwakami
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Clock outputs on the gate jacks.
+ *
+ * A gate jack can output MIDI clock divisions or a start trigger instead of the note
+ * gate. The pulses are scheduled at the clock times predicted by the MIDI clock tracker,
+ * and fired by the timer interrupt, so they stay in phase between the incoming clocks.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "voice.h"
+
+enum GateOutput {
+    GATE_OUTPUT_NOTE = 0,     // note gate
+    GATE_OUTPUT_24PPQN,       // every MIDI clock
+    GATE_OUTPUT_QUARTER,
+    GATE_OUTPUT_EIGHTH,
+    GATE_OUTPUT_SIXTEENTH,
+    GATE_OUTPUT_EIGHTH_TRIPLET,
+    GATE_OUTPUT_SIXTEENTH_TRIPLET,
+    GATE_OUTPUT_START,        // trigger on start
+    GATE_OUTPUT_END,
+};
+
+// Output modes of the gate jacks
+extern uint8_t gate_outputs[NUM_VOICES];
+
+/**
+ * Loads the gate output modes from EEPROM.
+ */
+extern void InitializeClockGates();
+
+/**
+ * Updates the output mode of a gate jack. Reconnect the voices to the key assigner
+ * when changed.
+ *
+ * @param voice - Voice of the gate jack
+ * @param new_gate_output - New output mode
+ * @param save - 1 to save the mode to EEPROM, 0 if the caller saves it by the write-back
+ * @returns 1 when the value has changed, 0 otherwise
+ */
+extern int8_t UpdateGateOutput(enum Voice voice, enum GateOutput new_gate_output, uint8_t save);
+
+/**
+ * Handles a MIDI clock while running.
+ *
+ * @param index - Position of the clock since the start
+ * @param now - timer_counter at the clock
+ */
+extern void ClockGateHandleClock(uint32_t index, uint32_t now);
+
+/**
+ * Handles a MIDI start.
+ */
+extern void ClockGateHandleStart(uint32_t now);
+
+/**
+ * Handles a MIDI stop. Cancels the pulses scheduled ahead.
+ */
+extern void ClockGateHandleStop();
+
+/**
+ * Fires the scheduled pulses. Called by the PWM_Bend cycle interrupt handler.
+ */
+extern void ClockGateHandleTick();
+
+/* [] END OF FILE */
@@ -24,10 +24,14 @@
 
 #include "project.h"
 
+#include "clock_gate.h"
 #include "config.h"
+#include "curve.h"
 #include "eeprom.h"
+#include "envelope.h"
 #include "hardware.h"
 #include "key_assigner.h"
+#include "lfo.h"
 #include "midi.h"
 #include "voice.h"
 
@@ -50,9 +54,33 @@ static a3_vector_t channels = {
     .data = &midi_config.channels,
 };
 
+static a3_vector_t curve_type_vector = {
+    .size = NUM_CURVES,
+    .data = curve_types,
+};
+
+static a3_vector_t curve_point_vector = {
+    .size = NUM_CURVES * CURVE_POINTS,
+    .data = curve_points,
+};
+
+static a3_vector_t gate_output_vector = {
+    .size = NUM_VOICES,
+    .data = gate_outputs,
+};
+
 static void CommitInteger(a3_property_t *, uint8_t *data, uint8_t len);
 static void CommitString(a3_property_t *, uint8_t *data, uint8_t len);
 static void CommitVectorU8(a3_property_t *, uint8_t *data, uint8_t len);
+static void CommitCurves(a3_property_t *, uint8_t *data, uint8_t len);
+static void CommitGateOutputs(a3_property_t *, uint8_t *data, uint8_t len);
+static void CommitLfoWave(a3_property_t *, uint8_t *data, uint8_t len);
+static void CommitEnvelopeMode(a3_property_t *, uint8_t *data, uint8_t len);
+static void CommitPressureRoute(a3_property_t *, uint8_t *data, uint8_t len);
+static void CommitMpeZone(a3_property_t *, uint8_t *data, uint8_t len);
+static void CommitGateOnPoint(a3_property_t *, uint8_t *data, uint8_t len);
+static void CommitPortamentMode(a3_property_t *, uint8_t *data, uint8_t len);
+static void CommitGlideTime(a3_property_t *, uint8_t *data, uint8_t len);
 
 a3_property_t config[NUM_PROPS] = {
     {
@@ -125,6 +153,146 @@ a3_property_t config[NUM_PROPS] = {
         .data = &midi_config.expression_or_breath,
         .commit = CommitInteger,
         .save_addr = ADDR_EXPRESSION_OR_BREATH,
+    }, {
+        .id = PROP_PORTAMENT_MODE,
+        .value_type = A3_U8,
+        .protected = 0,
+        .data = &portament_mode,
+        .commit = CommitPortamentMode,
+        .save_addr = ADDR_PORTAMENT_MODE,
+    }, {
+        .id = PROP_GLIDE_TIME,
+        .value_type = A3_U8,
+        .protected = 0,
+        .data = &glide_time,
+        .commit = CommitGlideTime,
+        .save_addr = ADDR_GLIDE_TIME,
+    }, {
+        .id = PROP_BEND_SMOOTHING_BYPASS,
+        .value_type = A3_U8,
+        .protected = 0,
+        .data = &bend_smoothing_bypass,
+        .commit = CommitInteger,
+        .save_addr = ADDR_BEND_SMOOTHING_BYPASS,
+    }, {
+        .id = PROP_SLEW_RISE,
+        .value_type = A3_U8,
+        .protected = 0,
+        .data = &slew_rise,
+        .commit = CommitInteger,
+        .save_addr = ADDR_SLEW_RISE,
+    }, {
+        .id = PROP_SLEW_FALL,
+        .value_type = A3_U8,
+        .protected = 0,
+        .data = &slew_fall,
+        .commit = CommitInteger,
+        .save_addr = ADDR_SLEW_FALL,
+    }, {
+        .id = PROP_CURVE_TYPES,
+        .value_type = A3_VECTOR_U8,
+        .protected = 0,
+        .data = &curve_type_vector,
+        .commit = CommitCurves,
+        .save_addr = ADDR_CURVE_TYPES,
+    }, {
+        .id = PROP_CURVE_POINTS,
+        .value_type = A3_VECTOR_U8,
+        .protected = 0,
+        .data = &curve_point_vector,
+        .commit = CommitCurves,
+        .save_addr = ADDR_CURVE_POINTS,
+    }, {
+        .id = PROP_GATE_DELAY_MAX,
+        .value_type = A3_U8,
+        .protected = 0,
+        .data = &gate_delay_max,
+        .commit = CommitInteger,
+        .save_addr = ADDR_GATE_DELAY_MAX,
+    }, {
+        .id = PROP_GATE_OUTPUTS,
+        .value_type = A3_VECTOR_U8,
+        .protected = 0,
+        .data = &gate_output_vector,
+        .commit = CommitGateOutputs,
+        .save_addr = ADDR_GATE_OUTPUTS,
+    }, {
+        .id = PROP_LFO_WAVE,
+        .value_type = A3_U8,
+        .protected = 0,
+        .data = &lfo_wave,
+        .commit = CommitLfoWave,
+        .save_addr = ADDR_LFO_WAVE,
+    }, {
+        .id = PROP_LFO_RATE,
+        .value_type = A3_U8,
+        .protected = 0,
+        .data = &lfo_rate,
+        .commit = CommitInteger,
+        .save_addr = ADDR_LFO_RATE,
+    }, {
+        .id = PROP_LFO_SYNC,
+        .value_type = A3_U8,
+        .protected = 0,
+        .data = &lfo_sync,
+        .commit = CommitInteger,
+        .save_addr = ADDR_LFO_SYNC,
+    }, {
+        .id = PROP_ENVELOPE_MODE,
+        .value_type = A3_U8,
+        .protected = 0,
+        .data = &envelope_mode,
+        .commit = CommitEnvelopeMode,
+        .save_addr = ADDR_ENVELOPE_MODE,
+    }, {
+        .id = PROP_ENVELOPE_ATTACK,
+        .value_type = A3_U8,
+        .protected = 0,
+        .data = &envelope_attack,
+        .commit = CommitInteger,
+        .save_addr = ADDR_ENVELOPE_ATTACK,
+    }, {
+        .id = PROP_ENVELOPE_DECAY,
+        .value_type = A3_U8,
+        .protected = 0,
+        .data = &envelope_decay,
+        .commit = CommitInteger,
+        .save_addr = ADDR_ENVELOPE_DECAY,
+    }, {
+        .id = PROP_ENVELOPE_SUSTAIN,
+        .value_type = A3_U8,
+        .protected = 0,
+        .data = &envelope_sustain,
+        .commit = CommitInteger,
+        .save_addr = ADDR_ENVELOPE_SUSTAIN,
+    }, {
+        .id = PROP_ENVELOPE_RELEASE,
+        .value_type = A3_U8,
+        .protected = 0,
+        .data = &envelope_release,
+        .commit = CommitInteger,
+        .save_addr = ADDR_ENVELOPE_RELEASE,
+    }, {
+        .id = PROP_PRESSURE_ROUTE,
+        .value_type = A3_U8,
+        .protected = 0,
+        .data = &pressure_route,
+        .commit = CommitPressureRoute,
+        .save_addr = ADDR_PRESSURE_ROUTE,
+    }, {
+        .id = PROP_MPE_ZONE,
+        .value_type = A3_U8,
+        .protected = 0,
+        .data = &midi_config.mpe_zone,
+        .commit = CommitMpeZone,
+        .save_addr = ADDR_MPE_ZONE,
+    }, {
+        .id = PROP_GATE_ON_POINT,
+        .value_type = A3_U16,
+        .protected = 0,
+        .data = &gate_on_point,
+        .commit = CommitGateOnPoint,
+        .save_addr = ADDR_GATE_ON_POINT,
     },
 };
 
@@ -137,7 +305,7 @@ void CommitInteger(a3_property_t *prop, uint8_t *data, uint8_t len)
     EEPROM_UpdateTemperature();
     switch (prop->value_type) {
     case A3_U8:
-        EEPROM_WriteByte(*(uint8_t *)prop->data, prop->save_addr);
+        Save8(*(uint8_t *)prop->data, prop->save_addr);
         break;
     case A3_U16:
         Save16(*(uint16_t *)prop->data, prop->save_addr);
@@ -170,8 +338,169 @@ void CommitVectorU8(a3_property_t *prop, uint8_t *data, uint8_t len)
     EEPROM_UpdateTemperature();
     uint8_t *elements = (uint8_t *)value->data;
     for (size_t i = 0; i < size; ++i) {
-        while (CYRET_LOCKED == EEPROM_WriteByte(elements[i], prop->save_addr + i)) {}
+        while (CYRET_LOCKED == Save8(elements[i], prop->save_addr + i)) {}
+    }
+}
+
+void CommitCurves(a3_property_t *prop, uint8_t *data, uint8_t len)
+{
+    if (prop->id == PROP_CURVE_TYPES) {
+        for (uint8_t i = 0; i < len; ++i) {
+            if (data[i] >= CURVE_TYPE_END) {
+                // invalid curve type, reject
+                return;
+            }
+        }
+    }
+    // The curve points are too many bytes to write at once without stalling MIDI, so
+    // they are saved by the write-back as the SysEx records are
+    a3_property_t unsaved = *prop;
+    unsaved.save_addr = ADDR_UNSET;
+    CommitVectorU8(&unsaved, data, len);
+    WriteBackProperty(prop);
+    BuildCurves();
+}
+
+void CommitGateOutputs(a3_property_t *prop, uint8_t *data, uint8_t len)
+{
+    size_t size = MIN(NUM_VOICES, len);
+    for (size_t i = 0; i < size; ++i) {
+        if (data[i] >= GATE_OUTPUT_END) {
+            // invalid output mode, reject
+            return;
+        }
+    }
+    uint8_t changed = 0;
+    for (size_t i = 0; i < size; ++i) {
+        changed |= UpdateGateOutput(i, data[i], prop->save_addr != ADDR_UNSET);
+    }
+    if (changed) {
+        KeyAssigner_ConnectVoices();
+    }
+}
+
+void CommitPropertyUnsaved(a3_property_t *prop, uint8_t *data, uint8_t len)
+{
+    if (prop->protected || prop->commit == NULL) {
+        return;
+    }
+    a3_property_t unsaved = *prop;
+    unsaved.save_addr = ADDR_UNSET;
+    prop->commit(&unsaved, data, len);
+}
+
+void WriteBackProperty(const a3_property_t *prop)
+{
+    if (prop->save_addr == ADDR_UNSET) {
+        return;
+    }
+    const uint8_t *data;
+    uint8_t size;
+    switch (prop->value_type) {
+    case A3_U8:
+        WriteBackEepromByte(*(uint8_t *)prop->data, prop->save_addr);
+        return;
+    case A3_U16: {
+        // big endian as Save16()
+        uint16_t value = *(uint16_t *)prop->data;
+        WriteBackEepromByte(value >> 8, prop->save_addr);
+        WriteBackEepromByte(value & 0xff, prop->save_addr + 1);
+        return;
+    }
+    case A3_U32: {
+        uint32_t value = *(uint32_t *)prop->data;
+        for (int i = 0; i < 4; ++i) {
+            WriteBackEepromByte(value >> (24 - i * 8), prop->save_addr + i);
+        }
+        return;
+    }
+    case A3_STRING:
+        // length first as SaveString()
+        data = (const uint8_t *)prop->data;
+        size = MIN(strlen(prop->data), A3_MAX_CONFIG_DATA_LENGTH - 1);
+        WriteBackEepromByte(size, prop->save_addr);
+        for (uint8_t i = 0; i < size; ++i) {
+            WriteBackEepromByte(data[i], prop->save_addr + 1 + i);
+        }
+        return;
+    case A3_VECTOR_U8: {
+        const a3_vector_t *vector = (const a3_vector_t *)prop->data;
+        data = (const uint8_t *)vector->data;
+        for (uint8_t i = 0; i < vector->size; ++i) {
+            WriteBackEepromByte(data[i], prop->save_addr + i);
+        }
+        return;
+    }
+    }
+}
+
+void CommitLfoWave(a3_property_t *prop, uint8_t *data, uint8_t len)
+{
+    if (len < 1 || data[0] >= LFO_WAVE_END) {
+        // invalid wave, reject
+        return;
+    }
+    CommitInteger(prop, data, len);
+}
+
+void CommitEnvelopeMode(a3_property_t *prop, uint8_t *data, uint8_t len)
+{
+    if (len < 1 || data[0] >= ENVELOPE_MODE_END) {
+        // invalid mode, reject
+        return;
+    }
+    CommitInteger(prop, data, len);
+}
+
+void CommitPressureRoute(a3_property_t *prop, uint8_t *data, uint8_t len)
+{
+    if (len < 1 || data[0] >= PRESSURE_ROUTE_END) {
+        // invalid route, reject
+        return;
+    }
+    CommitInteger(prop, data, len);
+}
+
+void CommitMpeZone(a3_property_t *prop, uint8_t *data, uint8_t len)
+{
+    if (len < 1 || data[0] >= MPE_ZONE_END) {
+        // invalid zone, reject
+        return;
+    }
+    CommitInteger(prop, data, len);
+    AssignMidiChannels();
+}
+
+void CommitPortamentMode(a3_property_t *prop, uint8_t *data, uint8_t len)
+{
+    if (len < 1) {
+        return;
+    }
+    enum PortamentMode value = data[0] < PORTAMENT_MODE_END ? data[0] : PORTAMENT_MODE_END - 1;
+    UpdatePortamentMode(value, prop->save_addr != ADDR_UNSET);
+}
+
+void CommitGlideTime(a3_property_t *prop, uint8_t *data, uint8_t len)
+{
+    if (len < 1) {
+        return;
+    }
+    UpdateGlideTime(data[0], prop->save_addr != ADDR_UNSET);
+}
+
+void CommitGateOnPoint(a3_property_t *prop, uint8_t *data, uint8_t len)
+{
+    uint16_t value;
+    if (len != sizeof(value)) {
+        return;
+    }
+    memcpy(&value, data, sizeof(value));
+    if (value >= GATE_DAC_STEPS) {
+        // out of the DAC range, reject
+        return;
     }
+    CommitInteger(prop, data, len);
+    BuildCurves();
 }
 
 /* [] END OF FILE */
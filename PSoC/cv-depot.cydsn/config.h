@@ -37,13 +37,31 @@
 #define PROP_GATE_TYPE 7
 #define PROP_BEND_DEPTH 8
 #define PROP_EXPRESSION_OR_BREATH 9
-#define NUM_PROPS 10
+#define PROP_PORTAMENT_MODE 10
+#define PROP_GLIDE_TIME 11
+#define PROP_BEND_SMOOTHING_BYPASS 12
+#define PROP_SLEW_RISE 13
+#define PROP_SLEW_FALL 14
+#define PROP_CURVE_TYPES 15
+#define PROP_CURVE_POINTS 16
+#define PROP_GATE_DELAY_MAX 17
+#define PROP_GATE_OUTPUTS 18
+#define PROP_LFO_WAVE 19
+#define PROP_LFO_RATE 20
+#define PROP_LFO_SYNC 21
+#define PROP_ENVELOPE_MODE 22
+#define PROP_ENVELOPE_ATTACK 23
+#define PROP_ENVELOPE_DECAY 24
+#define PROP_ENVELOPE_SUSTAIN 25
+#define PROP_ENVELOPE_RELEASE 26
+#define PROP_PRESSURE_ROUTE 27
+#define PROP_MPE_ZONE 28
+#define PROP_GATE_ON_POINT 29
+#define NUM_PROPS 30
 /*
 TBD
 #define PROP_RETRIGGER 7
 #define TYPE_RETRIGGER A3_U8
-#define PROP_PORTAMENT_MODE 8
-#define TYPE_PORTAMENT_MODE A3_U8
 #define PROP_PORTAMENT_DIRECTION 9
 #define TYPE_PORTAMENT_DIRECTION A3_U8
 #define PROP_PORTAMENT_TIME 10
@@ -54,4 +72,14 @@ extern char module_name[A3_MAX_CONFIG_DATA_LENGTH];
 
 extern a3_property_t config[NUM_PROPS];
 
+/**
+ * Commits a value to a property without saving it to EEPROM.
+ */
+extern void CommitPropertyUnsaved(a3_property_t *prop, uint8_t *data, uint8_t len);
+
+/**
+ * Saves the current value of a property by the EEPROM write-back.
+ */
+extern void WriteBackProperty(const a3_property_t *prop);
+
 /* [] END OF FILE */
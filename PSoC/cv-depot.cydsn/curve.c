@@ -0,0 +1,144 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2025 Naoki Iwakami
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "project.h"
+
+#include "curve.h"
+#include "eeprom.h"
+
+// Output ranges
+#define MODULATION_DAC_STEPS 2024
+
+// The standard curves
+#define FIXED_POINT_BITSHIFT 18
+#define MAX_VELOCITY 127
+#define MODULATION_DAC_VALUE(modulation) ((((uint16_t)(modulation) * (uint16_t)(modulation)) >> 4) + ((uint16_t)modulation << 3))
+
+// Shapes are computed in Q12
+#define SHAPE_ONE 4096
+#define MAX_X (CURVE_SIZE - 1)
+#define MAX_X_CUBED ((uint64_t)MAX_X * MAX_X * MAX_X)
+
+uint8_t curve_types[NUM_CURVES];
+uint8_t curve_points[NUM_CURVES][CURVE_POINTS];
+uint16_t curve_tables[NUM_CURVES][CURVE_SIZE];
+uint16_t gate_on_point;
+
+static const uint16_t kMaxValue[NUM_CURVES] = { GATE_DAC_STEPS, MODULATION_DAC_STEPS, MODULATION_DAC_STEPS };
+
+static uint16_t MinValue(enum CurveId id)
+{
+    return id == CURVE_VELOCITY ? gate_on_point : 0;
+}
+
+static uint16_t StandardValue(enum CurveId id, uint8_t x)
+{
+    if (id != CURVE_VELOCITY) {
+        return MODULATION_DAC_VALUE(x);
+    }
+    // quadratic from the gate-on point
+    uint32_t factor =
+        ((uint32_t)(GATE_DAC_STEPS - gate_on_point) << FIXED_POINT_BITSHIFT) / MAX_VELOCITY / MAX_VELOCITY;
+    return (((uint32_t)x * x * factor) >> FIXED_POINT_BITSHIFT) + gate_on_point;
+}
+
+static uint16_t Cube(uint8_t x)
+{
+    return (uint64_t)x * x * x * SHAPE_ONE / MAX_X_CUBED;
+}
+
+static uint16_t CustomShape(const uint8_t points[CURVE_POINTS], uint8_t x)
+{
+    uint8_t i = x >> 3;
+    int16_t y0 = points[i];
+    int16_t y1 = points[i + 1];
+    // the last segment ends at 127 instead of 128
+    uint8_t width = i == CURVE_POINTS - 2 ? 7 : 8;
+    int32_t y = y0 * width + (y1 - y0) * (x & 0x7);
+    return y * SHAPE_ONE / (width * 255);
+}
+
+static uint16_t Shape(enum CurveId id, uint8_t x)
+{
+    switch (curve_types[id]) {
+    case CURVE_LINEAR:
+        return (uint32_t)x * SHAPE_ONE / MAX_X;
+    case CURVE_EXPONENTIAL:
+        return Cube(x);
+    case CURVE_LOGARITHMIC:
+        return SHAPE_ONE - Cube(MAX_X - x);
+    case CURVE_S_SHAPE:
+        // 3t^2 - 2t^3
+        return ((uint64_t)3 * x * x * MAX_X - (uint64_t)2 * x * x * x) * SHAPE_ONE / MAX_X_CUBED;
+    case CURVE_CUSTOM:
+        return CustomShape(curve_points[id], x);
+    }
+    return 0;
+}
+
+void BuildCurves()
+{
+    for (uint8_t id = 0; id < NUM_CURVES; ++id) {
+        uint16_t *table = curve_tables[id];
+        if (curve_types[id] == CURVE_STANDARD) {
+            for (uint8_t x = 0; x < CURVE_SIZE; ++x) {
+                table[x] = StandardValue(id, x);
+            }
+            continue;
+        }
+        uint16_t min_value = MinValue(id);
+        uint32_t range = kMaxValue[id] - min_value;
+        for (uint8_t x = 0; x < CURVE_SIZE; ++x) {
+            table[x] = min_value + ((range * Shape(id, x)) >> 12);
+        }
+    }
+}
+
+void InitializeCurves()
+{
+    gate_on_point = Load16(ADDR_GATE_ON_POINT);
+    if (gate_on_point >= GATE_DAC_STEPS) {
+        gate_on_point = DEFAULT_GATE_ON_POINT;
+    }
+    for (uint8_t id = 0; id < NUM_CURVES; ++id) {
+        curve_types[id] = ReadEepromWithValueCheck(ADDR_CURVE_TYPES + id, CURVE_TYPE_END);
+        for (uint8_t i = 0; i < CURVE_POINTS; ++i) {
+            curve_points[id][i] = EEPROM_ReadByte(ADDR_CURVE_POINTS + id * CURVE_POINTS + i);
+        }
+    }
+    BuildCurves();
+}
+
+uint16_t CurveValue14(enum CurveId curve_id, uint16_t value)
+{
+    const uint16_t *table = curve_tables[curve_id];
+    uint8_t index = (value >> 7) & 0x7f;
+    uint8_t fraction = value & 0x7f;
+    if (fraction == 0 || index == CURVE_SIZE - 1) {
+        return table[index];
+    }
+    return table[index] + ((((int32_t)table[index + 1] - table[index]) * fraction) >> 7);
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,88 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2025 Naoki Iwakami
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Response curves of the velocity, expression and modulation outputs.
+ *
+ * The curves are kept as 128-entry lookup tables from MIDI values to DAC values, so that
+ * a gate-on or a control change costs a table read. The tables are rebuilt only when the
+ * curve settings change.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+enum CurveType {
+    CURVE_STANDARD = 0,  // the fixed curve of the output
+    CURVE_LINEAR,
+    CURVE_EXPONENTIAL,
+    CURVE_LOGARITHMIC,
+    CURVE_S_SHAPE,
+    CURVE_CUSTOM,        // interpolated between the uploaded points
+    CURVE_TYPE_END,
+};
+
+enum CurveId {
+    CURVE_VELOCITY = 0,
+    CURVE_EXPRESSION,
+    CURVE_MODULATION,
+    NUM_CURVES,
+};
+
+// Custom curves are given by the points at the MIDI values 0, 8, 16, ... 128 (taken as 127),
+// 0-255 for the range of the output
+#define CURVE_POINTS 17
+#define CURVE_SIZE 128
+
+// DAC range of the velocity outputs. The gate-on point is the value at the lowest velocity,
+// set to where the envelope of the connected synth starts to open.
+#define GATE_DAC_STEPS 2040
+#define DEFAULT_GATE_ON_POINT 680
+extern uint16_t gate_on_point;
+
+extern uint8_t curve_types[NUM_CURVES];
+extern uint8_t curve_points[NUM_CURVES][CURVE_POINTS];
+extern uint16_t curve_tables[NUM_CURVES][CURVE_SIZE];
+
+#define CURVE_VALUE(curve_id, value) (curve_tables[curve_id][(value) & 0x7f])
+
+/**
+ * Returns the curve value of a 14-bit MIDI value, interpolated between the table entries
+ * by the lower 7 bits.
+ */
+extern uint16_t CurveValue14(enum CurveId curve_id, uint16_t value);
+
+/**
+ * Loads the curve settings from EEPROM and builds the tables.
+ */
+extern void InitializeCurves();
+
+/**
+ * Rebuilds the tables from curve_types, curve_points and gate_on_point. Call this after
+ * changing them.
+ */
+extern void BuildCurves();
+
+/* [] END OF FILE */
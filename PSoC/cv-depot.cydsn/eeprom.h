@@ -41,11 +41,37 @@
 #define ADDR_GATE_TYPE 0x60
 #define ADDR_BEND_DEPTH 0x61
 #define ADDR_EXPRESSION_OR_BREATH 0x62
+#define ADDR_PORTAMENT_MODE 0x63
+#define ADDR_GLIDE_TIME 0x64
+#define ADDR_BEND_SMOOTHING_BYPASS 0x65
+#define ADDR_SLEW_RISE 0x66
+#define ADDR_SLEW_FALL 0x67
+#define ADDR_CURVE_TYPES 0x68 /* - 0x6b */
+#define ADDR_CURVE_POINTS 0x6b /* - 0x9e */
+#define ADDR_GATE_DELAY_MAX 0x9e
+#define ADDR_GATE_OUTPUTS 0x9f /* - 0xa1 */
+#define ADDR_LFO_WAVE 0xa1
+#define ADDR_LFO_RATE 0xa2
+#define ADDR_LFO_SYNC 0xa3
+#define ADDR_ENVELOPE_MODE 0xa4
+#define ADDR_ENVELOPE_ATTACK 0xa5
+#define ADDR_ENVELOPE_DECAY 0xa6
+#define ADDR_ENVELOPE_SUSTAIN 0xa7
+#define ADDR_ENVELOPE_RELEASE 0xa8
+#define ADDR_PRESSURE_ROUTE 0xa9
+#define ADDR_MPE_ZONE 0xaa
+#define ADDR_GATE_ON_POINT 0xab /* - 0xad */
 
 #define ADDR_UNSET 0xffff
 
 extern uint8_t ReadEepromWithValueCheck(uint16 address, uint8_t max);
 
+/**
+ * Writes a byte to the EEPROM at once. Use it, or the functions below, instead of
+ * EEPROM_WriteByte(), so that the write-back cache stays coherent with the EEPROM.
+ */
+extern cystatus Save8(uint8_t data, uint16_t address);
+
 extern cystatus Save16(uint16_t data, uint16_t address);
 extern uint16_t Load16(uint16_t address);
 
@@ -55,4 +81,15 @@ extern uint32_t Load32(uint16_t address);
 extern void SaveString(const char *string, size_t max_length, uint16_t address);
 extern void LoadString(char *string, size_t max_length, uint16_t address);
 
+/**
+ * Writes a byte through the write-back cache. The rows are written by EepromWriteBackTask()
+ * without blocking, one at a time. Use it for bulk writes that must not stall MIDI.
+ */
+extern void WriteBackEepromByte(uint8_t value, uint16_t address);
+
+/**
+ * Starts writing the next dirty row if the EEPROM is idle. Called by the main loop.
+ */
+extern void EepromWriteBackTask();
+
 /* [] END OF FILE */
@@ -42,11 +42,11 @@ cystatus Save16(uint16_t data, uint16_t address)
     EEPROM_UpdateTemperature();
     cystatus ret;
     // big endian
-    ret = EEPROM_WriteByte(data >> 8, address);
+    ret = Save8(data >> 8, address);
     if (ret != CYRET_SUCCESS) {
         return ret;
     }
-    return EEPROM_WriteByte(data & 0xff, address + 1);
+    return Save8(data & 0xff, address + 1);
 }
 
 uint16_t Load16(uint16_t address)
@@ -65,7 +65,7 @@ cystatus Save32(uint32_t data, uint16_t address)
     cystatus ret;
     // big endian
     for (int i = 0; i < 4; ++i) {
-        ret = EEPROM_WriteByte(data >> (24 - i * 8), address + i);
+        ret = Save8(data >> (24 - i * 8), address + i);
         if (ret != CYRET_SUCCESS) {
             return ret;
         }
@@ -89,10 +89,10 @@ void SaveString(const char *string, size_t max_length, uint16_t address)
 {
     size_t length = MIN(strlen(string), max_length - 1);
     EEPROM_UpdateTemperature();
-    while (CYRET_LOCKED == EEPROM_WriteByte((uint8_t) (length & 0xff), address)) {}
+    while (CYRET_LOCKED == Save8((uint8_t) (length & 0xff), address)) {}
     ++address;
     for (size_t i = 0; i < length; ++i) {
-        while (CYRET_LOCKED == EEPROM_WriteByte((uint8_t)string[i], address)) {}
+        while (CYRET_LOCKED == Save8((uint8_t)string[i], address)) {}
         ++address;
     }
 }
@@ -107,4 +107,84 @@ void LoadString(char *string, size_t max_length, uint16_t address)
     string[length] = 0;
 }
 
+// Write-back cache of the rows in the config area, 0x000-0x0ff. A row is copied from the
+// EEPROM when it is first written back, and every write keeps the copy up to date after.
+#define WRITE_BACK_ROWS 16
+
+static uint8_t write_back_rows[WRITE_BACK_ROWS][CYDEV_EEPROM_ROW_SIZE];
+static uint16_t cached_rows;
+static uint16_t dirty_rows;
+static int8_t writing_row = -1;
+
+/**
+ * Checks the row being written in the background. A failed row is marked dirty again to
+ * be retried.
+ *
+ * @return 1 if the write is still in progress, holding the EEPROM
+ */
+static uint8_t IsWritingRow()
+{
+    if (writing_row < 0) {
+        return 0;
+    }
+    cystatus status = EEPROM_Query();
+    if (status == CYRET_STARTED) {
+        return 1;
+    }
+    if (status != CYRET_SUCCESS) {
+        dirty_rows |= 1u << writing_row;
+    }
+    writing_row = -1;
+    return 0;
+}
+
+cystatus Save8(uint8_t data, uint16_t address)
+{
+    // the background write holds the EEPROM until it completes
+    while (IsWritingRow()) {}
+    cystatus ret = EEPROM_WriteByte(data, address);
+    uint8_t row = address / CYDEV_EEPROM_ROW_SIZE;
+    if (row < WRITE_BACK_ROWS && (cached_rows & (1u << row))) {
+        // the next write-back of the row must not undo this write
+        write_back_rows[row][address % CYDEV_EEPROM_ROW_SIZE] = data;
+        if (ret != CYRET_SUCCESS) {
+            dirty_rows |= 1u << row;
+        }
+    }
+    return ret;
+}
+
+void WriteBackEepromByte(uint8_t value, uint16_t address)
+{
+    uint8_t row = address / CYDEV_EEPROM_ROW_SIZE;
+    if (row >= WRITE_BACK_ROWS) {
+        while (CYRET_LOCKED == Save8(value, address)) {}
+        return;
+    }
+    if (!(cached_rows & (1u << row))) {
+        memcpy(write_back_rows[row], (const void *)(CYDEV_EE_BASE + row * CYDEV_EEPROM_ROW_SIZE),
+               CYDEV_EEPROM_ROW_SIZE);
+        cached_rows |= 1u << row;
+    }
+    write_back_rows[row][address % CYDEV_EEPROM_ROW_SIZE] = value;
+    dirty_rows |= 1u << row;
+}
+
+void EepromWriteBackTask()
+{
+    if (IsWritingRow() || dirty_rows == 0) {
+        return;
+    }
+    uint8_t row = 0;
+    while (!(dirty_rows & (1u << row))) {
+        ++row;
+    }
+    EEPROM_UpdateTemperature();
+    // a locked or failed start leaves the row dirty for the next pass
+    if (EEPROM_StartWrite(write_back_rows[row], row) == CYRET_SUCCESS) {
+        dirty_rows &= ~(1u << row);
+        writing_row = row;
+    }
+}
+
 /* [] END OF FILE */
@@ -0,0 +1,155 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2025 Naoki Iwakami
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "project.h"
+
+#include "eeprom.h"
+#include "envelope.h"
+
+enum EnvelopeStage {
+    STAGE_IDLE = 0,  // at the level, nothing to do
+    STAGE_ATTACK,
+    STAGE_DECAY,
+    STAGE_SUSTAIN,
+    STAGE_RELEASE,
+};
+
+// Levels are DAC values in Q16.16
+typedef struct envelope {
+    uint8_t stage;
+    uint16_t ticks;  // remaining in the segment
+    int32_t level;
+    int32_t target;  // at the end of the segment
+    int32_t step;
+    int32_t peak;
+    uint16_t output;
+    void (*write)(uint16_t value);
+} envelope_t;
+
+uint8_t envelope_mode;
+uint8_t envelope_attack;
+uint8_t envelope_decay;
+uint8_t envelope_sustain;
+uint8_t envelope_release;
+
+static envelope_t envelopes[NUM_VOICES] = {
+    { .write = DVDAC_Velocity_1_SetValue },
+    { .write = DVDAC_Velocity_2_SetValue },
+};
+
+static uint8_t ReadTime(uint16_t address, uint8_t default_value)
+{
+    uint8_t value = EEPROM_ReadByte(address);
+    return value == 0xff ? default_value : value;
+}
+
+void InitializeEnvelopes()
+{
+    envelope_mode = ReadEepromWithValueCheck(ADDR_ENVELOPE_MODE, ENVELOPE_MODE_END);
+    envelope_attack = ReadTime(ADDR_ENVELOPE_ATTACK, DEFAULT_ENVELOPE_ATTACK);
+    envelope_decay = ReadTime(ADDR_ENVELOPE_DECAY, DEFAULT_ENVELOPE_DECAY);
+    envelope_sustain = EEPROM_ReadByte(ADDR_ENVELOPE_SUSTAIN);  // full if not saved
+    envelope_release = ReadTime(ADDR_ENVELOPE_RELEASE, DEFAULT_ENVELOPE_RELEASE);
+    for (uint8_t i = 0; i < NUM_VOICES; ++i) {
+        envelopes[i].stage = STAGE_IDLE;
+        envelopes[i].level = 0;
+        envelopes[i].output = 0;
+    }
+}
+
+/**
+ * Starts a linear segment toward the target. The division is done here once, so that
+ * a step costs an addition.
+ */
+static void StartSegment(envelope_t *envelope, uint8_t stage, int32_t target, uint8_t time)
+{
+    envelope->stage = stage;
+    envelope->target = target;
+    envelope->ticks = time * ENVELOPE_TICKS_PER_UNIT;
+    if (envelope->ticks == 0) {
+        envelope->ticks = 1;
+    }
+    envelope->step = (target - envelope->level) / envelope->ticks;
+}
+
+static void StartDecay(envelope_t *envelope)
+{
+    if (envelope_mode == ENVELOPE_ADSR) {
+        int32_t sustain = ((envelope->peak >> 8) * envelope_sustain / 255) << 8;
+        StartSegment(envelope, STAGE_DECAY, sustain, envelope_decay);
+    } else {
+        envelope->stage = STAGE_SUSTAIN;
+    }
+}
+
+void EnvelopeGateOn(enum Voice voice, uint16_t peak)
+{
+    envelope_t *envelope = &envelopes[voice];
+    envelope->peak = (int32_t)peak << 16;
+    StartSegment(envelope, STAGE_ATTACK, envelope->peak, envelope_attack);
+}
+
+void EnvelopeGateOff(enum Voice voice)
+{
+    envelope_t *envelope = &envelopes[voice];
+    StartSegment(envelope, STAGE_RELEASE, 0, envelope_release);
+}
+
+void EnvelopeHandleTick()
+{
+    for (uint8_t i = 0; i < NUM_VOICES; ++i) {
+        envelope_t *envelope = &envelopes[i];
+        switch (envelope->stage) {
+        case STAGE_ATTACK:
+        case STAGE_DECAY:
+        case STAGE_RELEASE:
+            break;
+        default:
+            // holding the level
+            continue;
+        }
+        envelope->level += envelope->step;
+        if (--envelope->ticks == 0) {
+            envelope->level = envelope->target;
+            switch (envelope->stage) {
+            case STAGE_ATTACK:
+                StartDecay(envelope);
+                break;
+            case STAGE_DECAY:
+                envelope->stage = STAGE_SUSTAIN;
+                break;
+            default:
+                envelope->stage = STAGE_IDLE;
+                break;
+            }
+        }
+        uint16_t output = envelope->level >> 16;
+        if (output != envelope->output) {
+            envelope->output = output;
+            envelope->write(output);
+        }
+    }
+}
+
+/* [] END OF FILE */
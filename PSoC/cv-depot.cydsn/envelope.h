@@ -0,0 +1,82 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2025 Naoki Iwakami
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Envelopes of the velocity outputs.
+ *
+ * Optionally, the velocity DAC of a voice outputs an AR or ADSR envelope scaled by the
+ * velocity instead of the fixed level. The envelopes are triggered by the gate changes
+ * of the output frame and stepped at the control rate in linear segments.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "voice.h"
+
+enum EnvelopeMode {
+    ENVELOPE_OFF = 0,  // fixed level while the gate is on
+    ENVELOPE_AR,
+    ENVELOPE_ADSR,
+    ENVELOPE_MODE_END,
+};
+
+// Segment times in ENVELOPE_TICKS_PER_UNIT control ticks, 0 for no time
+#define ENVELOPE_TICKS_PER_UNIT 10  // 10ms
+#define DEFAULT_ENVELOPE_ATTACK 1
+#define DEFAULT_ENVELOPE_DECAY 30
+#define DEFAULT_ENVELOPE_RELEASE 20
+
+extern uint8_t envelope_mode;
+extern uint8_t envelope_attack;
+extern uint8_t envelope_decay;
+extern uint8_t envelope_sustain;  // 0-255 for 0-100% of the peak
+extern uint8_t envelope_release;
+
+/**
+ * Loads the envelope settings from EEPROM.
+ */
+extern void InitializeEnvelopes();
+
+/**
+ * Starts the attack toward the peak from the current level.
+ *
+ * @param voice - Voice to trigger
+ * @param peak - Peak DAC value, i.e., the velocity level
+ */
+extern void EnvelopeGateOn(enum Voice voice, uint16_t peak);
+
+/**
+ * Starts the release.
+ */
+extern void EnvelopeGateOff(enum Voice voice);
+
+/**
+ * Steps the envelopes and writes the velocity DACs. Called at the control rate by
+ * the PWM_Bend cycle interrupt handler.
+ */
+extern void EnvelopeHandleTick();
+
+/* [] END OF FILE */
@@ -24,8 +24,13 @@
 
 #include "project.h"
 
+#include "clock_gate.h"
+#include "curve.h"
 #include "eeprom.h"
+#include "envelope.h"
 #include "hardware.h"
+#include "lfo.h"
+#include "main.h"
 #include "pot.h"
 #include "pot_change.h"
 #include "voice.h"
@@ -34,8 +39,15 @@ uint16_t bend_offset;
 uint16_t bend_octave_width;
 uint32_t bend_halftone_width;
 uint8_t bend_depth;
+uint8_t bend_smoothing_bypass;
+uint8_t slew_rise;
+uint8_t slew_fall;
 
 enum GateType gate_type;
+uint8_t gate_delay_max;
+enum PortamentMode portament_mode;
+uint8_t pressure_route;
+uint8_t glide_time;
 
 // CAN message queue
 can_message_t message_queue[MESSAGE_QUEUE_SIZE];
@@ -44,28 +56,200 @@ uint32_t q_tail = 0;
 uint8_t q_full = 0;
 
 // macros
-#define SetNote1 PWM_Notes_WriteCompare1
-#define SetNote2 PWM_Notes_WriteCompare2
-
-// TODO: Make this value adjustable
-#define GATE_ON_POINT 680
-// #define GATE_ON_POINT 639
-#define GATE_DAC_STEPS 2040
-#define FIXED_POINT_BITSHIFT 18
-#define MAX_VELOCITY 127
-#define VELOCITY_FACTOR \
-    (uint32_t) (((GATE_DAC_STEPS - GATE_ON_POINT) << FIXED_POINT_BITSHIFT) / MAX_VELOCITY / MAX_VELOCITY)
-#define VELOCITY_DAC_VALUE(velocity) ((((velocity) * (velocity) * (VELOCITY_FACTOR)) >> FIXED_POINT_BITSHIFT) + GATE_ON_POINT)
-#define MODULATION_DAC_VALUE(modulation) ((((uint16_t)(modulation) * (uint16_t)(modulation)) >> 4) + ((uint16_t)modulation << 3))
+
 #define INDICATOR_VALUE(velocity) ((velocity) >= 64 ? (((velocity) - 63)  * ((velocity) - 63)) / 32 - 1 : 0)
 #define NOTE_PWM_MAX_VALUE 120
 
+/*
+ * Portament pot wiper positions for the portament time control values.
+ * The glide time is proportional to the wiper position. The table rises exponentially
+ * (wiper = 63 * (16^(value/127) - 1) / 15) so that the control feels even over the range.
+ */
+static const uint8_t kPortamentTimeWiper[128] = {
+     0,  0,  0,  0,  0,  0,  1,  1,  1,  1,  1,  1,  1,  1,  2,  2,
+     2,  2,  2,  2,  2,  2,  3,  3,  3,  3,  3,  3,  4,  4,  4,  4,
+     4,  4,  5,  5,  5,  5,  5,  6,  6,  6,  6,  7,  7,  7,  7,  8,
+     8,  8,  8,  9,  9,  9,  9, 10, 10, 10, 11, 11, 11, 12, 12, 12,
+    13, 13, 14, 14, 14, 15, 15, 16, 16, 16, 17, 17, 18, 18, 19, 19,
+    20, 20, 21, 22, 22, 23, 23, 24, 24, 25, 26, 26, 27, 28, 28, 29,
+    30, 31, 31, 32, 33, 34, 35, 36, 36, 37, 38, 39, 40, 41, 42, 43,
+    44, 45, 46, 48, 49, 50, 51, 52, 53, 55, 56, 57, 59, 60, 62, 63,
+};
+
+// Bend driver state, shared with the PWM_Bend cycle interrupt handler.
+// The positions and offsets are in bend steps, Q16.16.
+static volatile uint8_t bend_driver_enabled;
+static volatile int32_t bend_position;   // bend without glide
+static volatile int32_t bend_target;     // position set by the latest bend message
+static volatile int32_t bend_step;       // interpolation step toward the target
+static volatile uint32_t bend_ticks;     // remaining interpolation steps
+static uint32_t last_bend_time;          // timer_counter at the latest bend message
+// Bend messages further apart are taken as the start of a move
+#define BEND_SMOOTHING_MAX_TICKS (GLIDE_TICKS_PER_UNIT * 2)
+static uint16_t dither_error;            // sigma-delta accumulator
+static uint16_t bend_output;             // last value written to PWM_Bend
+#define BEND_OUTPUT_UNSET 0xffff
+
+// Digital glide state, also shared with the interrupt handler
+static volatile int32_t glide_offset;
+static volatile int32_t glide_step;      // quotient of the offset by the ticks
+static volatile uint32_t glide_remainder; // absolute remainder of the above
+static volatile uint32_t glide_error;    // accumulated remainder, Bresenham style
+static volatile int8_t glide_sign;
+static volatile uint32_t glide_total_ticks;
+static volatile uint32_t glide_ticks;    // remaining steps, 0 when not gliding
+static uint8_t glide_armed;              // the next note change of voice 1 glides
+static uint8_t last_note_1;
+
+// Slew limited DAC output, shared with the PWM_Bend cycle interrupt handler
+typedef struct slew {
+    volatile uint16_t target;
+    uint16_t current;
+    void (*write)(uint16_t value);
+} slew_t;
+
+static slew_t slew_expression = { .write = DVDAC_Expression_SetValue };
+static slew_t slew_modulation = { .write = DVDAC_Modulation_SetValue };
+static volatile uint16_t modulation_level;  // by CC1, the LFO depth while the LFO is on
+
+// Output frame of the voices. The voice_config_t methods stage the changes, and the PWM_Bend
+// cycle interrupt handler commits them all together at the next tick.
+#define FRAME_NOTE 0x01
+#define FRAME_GATE 0x02
+#define FRAME_PORTAMENT 0x04
+#define FRAME_PRESSURE 0x08
+typedef struct voice_output {
+    uint8_t changes;
+    uint8_t note;
+    uint8_t gate;
+    uint16_t velocity;  // velocity DAC value
+    uint8_t indicator;
+} voice_output_t;
+
+static volatile voice_output_t output_frame[NUM_VOICES];
+static volatile uint8_t frame_portament;
+static volatile uint8_t frame_changes;  // all changes in the frame
+static volatile uint8_t frame_held;
+
+// Portament switch, turned on and off by CC65
+enum PortamentSwitch {
+    PORTAMENT_SWITCH_NONE,  // not operated, follow the portament mode
+    PORTAMENT_SWITCH_ON,
+    PORTAMENT_SWITCH_OFF,
+};
+static enum PortamentSwitch portament_switch = PORTAMENT_SWITCH_NONE;
+
+static void StageNote(enum Voice voice, uint8_t note_number)
+{
+    uint8_t state = CyEnterCriticalSection();
+    output_frame[voice].note = note_number;
+    output_frame[voice].changes |= FRAME_NOTE;
+    frame_changes |= FRAME_NOTE;
+    CyExitCriticalSection(state);
+}
+
+static void StageGate(enum Voice voice, uint8_t gate, uint8_t velocity)
+{
+    uint8_t state = CyEnterCriticalSection();
+    output_frame[voice].gate = gate;
+    output_frame[voice].velocity = gate ? CURVE_VALUE(CURVE_VELOCITY, velocity) : 0;
+    output_frame[voice].indicator = INDICATOR_VALUE(velocity);
+    output_frame[voice].changes |= FRAME_GATE;
+    frame_changes |= FRAME_GATE;
+    CyExitCriticalSection(state);
+}
+
+static void StagePressure(enum Voice voice, uint8_t value)
+{
+    uint8_t state = CyEnterCriticalSection();
+    output_frame[voice].velocity = CURVE_VALUE(CURVE_VELOCITY, value);
+    output_frame[voice].changes |= FRAME_PRESSURE;
+    frame_changes |= FRAME_PRESSURE;
+    CyExitCriticalSection(state);
+}
+
+static void StagePortament(uint8_t on)
+{
+    uint8_t state = CyEnterCriticalSection();
+    frame_portament = on;
+    frame_changes |= FRAME_PORTAMENT;
+    CyExitCriticalSection(state);
+}
+
+void HoldOutputFrame()
+{
+    frame_held = 1;
+}
+
+void ReleaseOutputFrame()
+{
+    frame_held = 0;
+}
+
+static void SetVelocityOutput(enum Voice voice, volatile voice_output_t *output)
+{
+    if (envelope_mode == ENVELOPE_OFF) {
+        if (voice == VOICE_1) {
+            DVDAC_Velocity_1_SetValue(output->velocity);
+        } else {
+            DVDAC_Velocity_2_SetValue(output->velocity);
+        }
+    } else if (output->gate) {
+        EnvelopeGateOn(voice, output->velocity);
+    } else {
+        EnvelopeGateOff(voice);
+    }
+}
+
+void OutputFrameHandleTick()
+{
+    if (!frame_changes || frame_held) {
+        return;
+    }
+    if (frame_changes & FRAME_PORTAMENT) {
+        Pin_Portament_En_Write(frame_portament);
+    }
+
+    // CVs first, then gates
+    volatile voice_output_t *voice_1 = &output_frame[VOICE_1];
+    volatile voice_output_t *voice_2 = &output_frame[VOICE_2];
+    if (voice_1->changes & FRAME_NOTE) {
+        PWM_Notes_WriteCompare1(voice_1->note);
+    }
+    if (voice_2->changes & FRAME_NOTE) {
+        PWM_Notes_WriteCompare2(voice_2->note);
+    }
+    if (envelope_mode == ENVELOPE_OFF) {
+        // pressure while the gate is on, the gate changes below override it
+        if ((voice_1->changes & FRAME_PRESSURE) && voice_1->gate) {
+            DVDAC_Velocity_1_SetValue(voice_1->velocity);
+        }
+        if ((voice_2->changes & FRAME_PRESSURE) && voice_2->gate) {
+            DVDAC_Velocity_2_SetValue(voice_2->velocity);
+        }
+    }
+    if (voice_1->changes & FRAME_GATE) {
+        SetVelocityOutput(VOICE_1, voice_1);
+        if (voice_1->gate) {
+            PWM_Indicators_WriteCompare1(voice_1->indicator);
+        }
+        Pin_Gate_1_Write(voice_1->gate);
+    }
+    if (voice_2->changes & FRAME_GATE) {
+        SetVelocityOutput(VOICE_2, voice_2);
+        if (voice_2->gate) {
+            PWM_Indicators_WriteCompare2(voice_2->indicator);
+        }
+        Pin_Gate_2_Write(voice_2->gate);
+    }
+    voice_1->changes = 0;
+    voice_2->changes = 0;
+    frame_changes = 0;
+}
+
 static void Gate1On(uint8_t velocity)
 {
-    uint16_t gate_level = VELOCITY_DAC_VALUE(velocity);
-    DVDAC_Velocity_1_SetValue(gate_level);
-    PWM_Indicators_WriteCompare1(INDICATOR_VALUE(velocity));
-    Pin_Gate_1_Write(1);
+    StageGate(VOICE_1, 1, velocity);
 }
 
 static void Gate1OnLegacy(uint8_t velocity)
@@ -76,16 +260,125 @@ static void Gate1OnLegacy(uint8_t velocity)
 
 static void Gate1Off()
 {
-    Pin_Portament_En_Write(0);
-    DVDAC_Velocity_1_SetValue(0);
-    Pin_Gate_1_Write(0);
+    StageGate(VOICE_1, 0, 0);
 }
 
 static void Gate2On(uint8_t velocity)
 {
-    DVDAC_Velocity_2_SetValue(VELOCITY_DAC_VALUE(velocity));
-    PWM_Indicators_WriteCompare2(INDICATOR_VALUE(velocity));
-    Pin_Gate_2_Write(1);
+    StageGate(VOICE_2, 1, velocity);
+}
+
+/**
+ * Starts a glide from the given interval. A glide in progress continues from
+ * where it is, so that the pitch never jumps.
+ */
+static void StartGlide(int16_t interval)
+{
+    int32_t offset = (int32_t)interval * (int32_t)(bend_halftone_width << 10);
+    uint32_t ticks = (uint32_t)glide_time * GLIDE_TICKS_PER_UNIT;
+
+    uint8_t state = CyEnterCriticalSection();
+    offset += glide_offset;
+    if (offset > ((int32_t)BEND_STEPS << 16)) {
+        offset = (int32_t)BEND_STEPS << 16;
+    } else if (offset < -((int32_t)BEND_STEPS << 16)) {
+        offset = -((int32_t)BEND_STEPS << 16);
+    }
+    glide_offset = offset;
+    glide_step = offset / (int32_t)ticks;
+    glide_sign = offset < 0 ? -1 : 1;
+    glide_remainder = (offset - glide_step * (int32_t)ticks) * glide_sign;
+    glide_error = 0;
+    glide_total_ticks = ticks;
+    glide_ticks = ticks;
+    CyExitCriticalSection(state);
+}
+
+void BendHandleTick()
+{
+    if (!bend_driver_enabled) {
+        return;
+    }
+    if (bend_ticks) {
+        if (--bend_ticks == 0) {
+            bend_position = bend_target;
+        } else {
+            bend_position += bend_step;
+        }
+    }
+    if (glide_ticks) {
+        // Spread the remainder over the ramp so that it lands on 0 linearly
+        glide_offset -= glide_step;
+        glide_error += glide_remainder;
+        if (glide_error >= glide_total_ticks) {
+            glide_error -= glide_total_ticks;
+            glide_offset -= glide_sign;
+        }
+        --glide_ticks;
+    }
+
+    int32_t bend = bend_position + glide_offset;
+    if (bend < 0) {
+        bend = 0;
+    } else if (bend > ((int32_t)BEND_STEPS << 16)) {
+        bend = (int32_t)BEND_STEPS << 16;
+    }
+    // First order sigma-delta modulation: output the integer part and carry the
+    // fraction over, so that the average after the output filter has the full resolution.
+    uint32_t sum = (uint32_t)dither_error + (bend & 0xffff);
+    uint16_t output = (bend >> 16) + (sum >> 16);
+    dither_error = sum;
+    if (output != bend_output) {
+        PWM_Bend_WriteCompare(output);
+        bend_output = output;
+    }
+}
+
+void SuspendBendDriver()
+{
+    bend_driver_enabled = 0;
+}
+
+void ResumeBendDriver()
+{
+    uint8_t state = CyEnterCriticalSection();
+    glide_ticks = 0;
+    glide_offset = 0;
+    bend_ticks = 0;
+    bend_position = (int32_t)bend_offset << 16;
+    bend_target = bend_position;
+    dither_error = 0;
+    bend_output = BEND_OUTPUT_UNSET;
+    bend_driver_enabled = 1;
+    CyExitCriticalSection(state);
+}
+
+static void SetNote1(uint8_t note_number)
+{
+    if (glide_armed && glide_time) {
+        StartGlide((int16_t)last_note_1 - note_number);
+    }
+    glide_armed = 0;
+    last_note_1 = note_number;
+    StageNote(VOICE_1, note_number);
+}
+
+static void SetNote2(uint8_t note_number)
+{
+    StageNote(VOICE_2, note_number);
+}
+
+static void SetPortament(uint8_t on)
+{
+    if (glide_time) {
+        // Glide digitally on the bend PWM. The bend is shared by the voices, so the glide
+        // follows voice 1.
+        StagePortament(0);
+        glide_armed = on;
+        return;
+    }
+    // The switch is shared by the voices
+    StagePortament(on);
 }
 
 static void Gate2OnLegacy(uint8_t velocity)
@@ -96,8 +389,36 @@ static void Gate2OnLegacy(uint8_t velocity)
 
 static void Gate2Off()
 {
-    DVDAC_Velocity_2_SetValue(0);
-    Pin_Gate_2_Write(0);
+    StageGate(VOICE_2, 0, 0);
+}
+
+static void SetPressure1(uint8_t value)
+{
+    if (pressure_route == PRESSURE_TO_VELOCITY) {
+        StagePressure(VOICE_1, value);
+    }
+}
+
+static void SetPressure2(uint8_t value)
+{
+    if (pressure_route == PRESSURE_TO_VELOCITY) {
+        StagePressure(VOICE_2, value);
+    }
+}
+
+static void GateOnUnused(uint8_t velocity)
+{
+    // the gate jack outputs the clock
+    (void)velocity;
+}
+
+static void GateOffUnused()
+{
+}
+
+void SetClockGate(uint8_t voice, uint8_t on)
+{
+    StageGate(voice, on, 127);
 }
 
 void GetVoiceConfigs(voice_config_t voice_configs[], unsigned size)
@@ -108,6 +429,12 @@ void GetVoiceConfigs(voice_config_t voice_configs[], unsigned size)
     voice_configs[0].set_note = SetNote1;
     voice_configs[0].gate_on = gate_type == GATE_TYPE_VELOCITY ? Gate1On : Gate1OnLegacy;
     voice_configs[0].gate_off = Gate1Off;
+    if (gate_outputs[VOICE_1] != GATE_OUTPUT_NOTE) {
+        voice_configs[0].gate_on = GateOnUnused;
+        voice_configs[0].gate_off = GateOffUnused;
+    }
+    voice_configs[0].set_portament = SetPortament;
+    voice_configs[0].set_pressure = SetPressure1;
 
     if (size < 2) {
         return;
@@ -115,6 +442,12 @@ void GetVoiceConfigs(voice_config_t voice_configs[], unsigned size)
     voice_configs[1].set_note = SetNote2;
     voice_configs[1].gate_on = gate_type == GATE_TYPE_VELOCITY ? Gate2On : Gate2OnLegacy;
     voice_configs[1].gate_off = Gate2Off;
+    if (gate_outputs[VOICE_2] != GATE_OUTPUT_NOTE) {
+        voice_configs[1].gate_on = GateOnUnused;
+        voice_configs[1].gate_off = GateOffUnused;
+    }
+    voice_configs[1].set_portament = SetPortament;
+    voice_configs[1].set_pressure = SetPressure2;
 }
 
 int8_t UpdateGateType(enum GateType new_gate_type)
@@ -123,11 +456,41 @@ int8_t UpdateGateType(enum GateType new_gate_type)
         // no change, do nothing
         return 0;
     }
-    EEPROM_WriteByte(new_gate_type, ADDR_GATE_TYPE);
+    Save8(new_gate_type, ADDR_GATE_TYPE);
     gate_type = new_gate_type;
     return 1;
 }
 
+int8_t UpdatePortamentMode(enum PortamentMode new_portament_mode, uint8_t save)
+{
+    if (new_portament_mode == portament_mode) {
+        // no change, do nothing
+        return 0;
+    }
+    if (save) {
+        Save8(new_portament_mode, ADDR_PORTAMENT_MODE);
+    }
+    portament_mode = new_portament_mode;
+    // a new mode is to be heard, not overridden by a switch operated before
+    ResetPortamentSwitch();
+    if (portament_mode == PORTAMENT_OFF) {
+        StagePortament(0);
+    }
+    return 1;
+}
+
+enum PortamentMode GetEffectivePortamentMode()
+{
+    switch (portament_switch) {
+    case PORTAMENT_SWITCH_OFF:
+        return PORTAMENT_OFF;
+    case PORTAMENT_SWITCH_ON:
+        return portament_mode == PORTAMENT_OFF ? PORTAMENT_ALWAYS : portament_mode;
+    default:
+        return portament_mode;
+    }
+}
+
 void InitializeVoiceControl()
 {
     // setup hardware
@@ -142,13 +505,21 @@ void InitializeVoiceControl()
     DVDAC_Expression_Start();
     DVDAC_Modulation_Start();
 
+    // Pots - seek only the differences if we know where the wipers are
+    pot_t *const pots[NUM_POTS] = { &pot_note_1, &pot_note_2, &pot_portament_1, &pot_portament_2 };
+    uint8_t needs_homing = !PotChangeRestorePositions(pots);
+
     // Note CV
     uint8_t wiper = EEPROM_ReadByte(ADDR_NOTE_1_WIPER);
-    PotChangePlaceRequest(&pot_note_1, -1);  // move to termianl B to ensure the starting position
+    if (needs_homing) {
+        PotChangePlaceRequest(&pot_note_1, -1);  // move to termianl B to ensure the starting position
+    }
     PotChangePlaceRequest(&pot_note_1, wiper);
 
     wiper = EEPROM_ReadByte(ADDR_NOTE_2_WIPER);
-    PotChangePlaceRequest(&pot_note_2, -1);  // move to termianl B to ensure the starting position
+    if (needs_homing) {
+        PotChangePlaceRequest(&pot_note_2, -1);  // move to termianl B to ensure the starting position
+    }
     PotChangePlaceRequest(&pot_note_2, wiper);
 
     // Gate type
@@ -156,31 +527,74 @@ void InitializeVoiceControl()
     if (gate_type > GATE_TYPE_LEGACY) {
         gate_type = GATE_TYPE_VELOCITY;
     }
+    gate_delay_max = EEPROM_ReadByte(ADDR_GATE_DELAY_MAX);
+    if (gate_delay_max == 0xff) {
+        gate_delay_max = DEFAULT_GATE_DELAY_MAX;
+    }
+    InitializeClockGates();
 
     // Bend
     bend_offset = BEND_STEPS / 2;
     bend_octave_width = Load16(ADDR_BEND_OCTAVE_WIDTH);
     bend_halftone_width = ((uint32_t)bend_octave_width << 6) / 12;
     PWM_Bend_WriteCompare(bend_offset);
+    ResumeBendDriver();
     bend_depth = EEPROM_ReadByte(ADDR_BEND_DEPTH);
     if (bend_depth == 0 || bend_depth == 0xff) {
         UpdateBendDepth(4);
     }
+    bend_smoothing_bypass = ReadEepromWithValueCheck(ADDR_BEND_SMOOTHING_BYPASS, 2);
 
     // Portament
     Pin_Portament_En_Write(0);
-    // move pot terminals to B to ensure the starting positions
-    PotChangePlaceRequest(&pot_portament_1, -1);
-    PotChangePlaceRequest(&pot_portament_2, -1);
+    portament_mode = ReadEepromWithValueCheck(ADDR_PORTAMENT_MODE, PORTAMENT_MODE_END);
+    pressure_route = ReadEepromWithValueCheck(ADDR_PRESSURE_ROUTE, PRESSURE_ROUTE_END);
+    glide_time = ReadEepromWithValueCheck(ADDR_GLIDE_TIME, MAX_GLIDE_TIME + 1);
+    if (needs_homing) {
+        // move pot terminals to B to ensure the starting positions
+        PotChangePlaceRequest(&pot_portament_1, -1);
+        PotChangePlaceRequest(&pot_portament_2, -1);
+    }
     // then set the pot values
     PotChangePlaceRequest(&pot_portament_1, 2);
     PotChangePlaceRequest(&pot_portament_2, 2);
 
-    // Expression
-    SetExpression(0);
+    // Response curves
+    InitializeCurves();
 
-    // Modulation
+    // Expression and modulation
+    slew_rise = EEPROM_ReadByte(ADDR_SLEW_RISE);
+    if (slew_rise == 0xff) {
+        slew_rise = DEFAULT_SLEW_RATE;
+    }
+    slew_fall = EEPROM_ReadByte(ADDR_SLEW_FALL);
+    if (slew_fall == 0xff) {
+        slew_fall = DEFAULT_SLEW_RATE;
+    }
+    InitializeLfo();
+    InitializeEnvelopes();
+    SetExpression(0);
     SetModulation(0);
+    DVDAC_Expression_SetValue(0);
+    DVDAC_Modulation_SetValue(0);
+}
+
+void UpdateGlideTime(uint8_t new_glide_time, uint8_t save)
+{
+    if (new_glide_time > MAX_GLIDE_TIME) {
+        new_glide_time = MAX_GLIDE_TIME;
+    }
+    if (new_glide_time == glide_time) {
+        // no change, do nothing
+        return;
+    }
+    if (save) {
+        Save8(new_glide_time, ADDR_GLIDE_TIME);
+    }
+    glide_time = new_glide_time;
+    if (glide_time) {
+        StagePortament(0);
+    }
 }
 
 void UpdateBendDepth(uint8_t new_bend_depth)
@@ -189,34 +603,129 @@ void UpdateBendDepth(uint8_t new_bend_depth)
         // no change, do nothing
         return;
     }
-    EEPROM_WriteByte(new_bend_depth, ADDR_BEND_DEPTH);
+    Save8(new_bend_depth, ADDR_BEND_DEPTH);
+    bend_depth = new_bend_depth;
+}
+
+void SetBendDepth(uint8_t new_bend_depth)
+{
+    // 0 is valid, it turns the bend off
+    if (new_bend_depth > MAX_BEND_DEPTH) {
+        new_bend_depth = MAX_BEND_DEPTH;
+    }
     bend_depth = new_bend_depth;
 }
 
 void BendPitch(int16_t bend_amount)
 {
-    uint16_t bend;
+    BendPitchBySemitones((int32_t)bend_amount * bend_depth);
+}
+
+void BendPitchBySemitones(int32_t semitone_amount)
+{
+    // Keep the fraction in Q16.16, the interrupt handler dithers it out
+    int32_t bend = (int32_t)bend_offset << 16;
     const uint32_t kMidiBendMaxWidthBits = 13;
-    if (bend_amount >= 0) {
-        uint32_t temp = ((uint32_t)bend_amount * bend_halftone_width * bend_depth) >> (kMidiBendMaxWidthBits + 6);
-        bend = bend_offset + temp;
+    if (semitone_amount >= 0) {
+        uint32_t temp = ((uint64_t)semitone_amount * bend_halftone_width) >> (kMidiBendMaxWidthBits + 6 - 16);
+        bend += temp;
+    } else {
+        uint32_t temp = ((uint64_t)(-semitone_amount) * bend_halftone_width) >> (kMidiBendMaxWidthBits + 6 - 16);
+        bend -= temp;
+    }
+
+    // Interpolate over the interval of the bend messages, which the next one likely follows
+    uint32_t now = timer_counter;
+    uint32_t ticks = now - last_bend_time;
+    last_bend_time = now;
+    uint8_t state = CyEnterCriticalSection();
+    bend_target = bend;
+    // The first message of a move has no interval to go by, so it takes effect at once
+    if (bend_smoothing_bypass || ticks < 2 || ticks > BEND_SMOOTHING_MAX_TICKS) {
+        bend_position = bend;
+        bend_ticks = 0;
+    } else {
+        bend_step = (bend - bend_position) / (int32_t)ticks;
+        bend_ticks = ticks;
+    }
+    CyExitCriticalSection(state);
+}
+
+void SetExpression(uint16_t value)
+{
+    slew_expression.target = CurveValue14(CURVE_EXPRESSION, value);
+}
+
+void SetModulation(uint16_t value)
+{
+    modulation_level = CurveValue14(CURVE_MODULATION, value);
+}
+
+static void Slew(slew_t *slew)
+{
+    uint16_t target = slew->target;
+    if (target == slew->current) {
+        // no DAC write
+        return;
+    }
+    uint16_t limit;
+    if (target > slew->current) {
+        limit = slew_rise * SLEW_RATE_UNIT;
+        slew->current = limit && target - slew->current > limit ? slew->current + limit : target;
     } else {
-        uint32_t temp = ((uint32_t)(-bend_amount) * bend_halftone_width * bend_depth) >> (kMidiBendMaxWidthBits + 6);
-        bend = bend_offset - temp;
+        limit = slew_fall * SLEW_RATE_UNIT;
+        slew->current = limit && slew->current - target > limit ? slew->current - limit : target;
+    }
+    slew->write(slew->current);
+}
+
+void SlewHandleTick()
+{
+    uint16_t modulation = modulation_level;
+    if (lfo_wave != LFO_OFF) {
+        modulation = ((uint32_t)modulation * LfoHandleTick()) >> 8;
+    }
+    slew_modulation.target = modulation;
+
+    Slew(&slew_expression);
+    Slew(&slew_modulation);
+}
+
+void RoutePressure(uint8_t value)
+{
+    switch (pressure_route) {
+    case PRESSURE_TO_EXPRESSION:
+        SetExpression(value << 7);
+        break;
+    case PRESSURE_TO_MODULATION:
+        SetModulation(value << 7);
+        break;
+    default:
+        break;
     }
-    PWM_Bend_WriteCompare(bend);
 }
 
-void SetExpression(uint8_t value)
+void SetPortamentTime(uint8_t value)
 {
-    uint16_t amount = MODULATION_DAC_VALUE(value);
-    DVDAC_Expression_SetValue(amount);
+    uint8_t wiper = kPortamentTimeWiper[value & 0x7f];
+    // The pot driver keeps only the latest target, so a fast sweep costs nothing but the final seek.
+    PotChangePlaceRequest(&pot_portament_1, wiper);
+    PotChangePlaceRequest(&pot_portament_2, wiper);
+}
+
+void SetPortamentSwitch(uint8_t value)
+{
+    if (value >= 64) {
+        portament_switch = PORTAMENT_SWITCH_ON;
+    } else {
+        portament_switch = PORTAMENT_SWITCH_OFF;
+        StagePortament(0);
+    }
 }
 
-void SetModulation(uint8_t value)
+void ResetPortamentSwitch()
 {
-    uint16_t amount = MODULATION_DAC_VALUE(value);
-    DVDAC_Modulation_SetValue(amount);
+    portament_switch = PORTAMENT_SWITCH_NONE;
 }
 
 static void InitSysTimer(uint16_t interval_ms)
@@ -52,15 +52,106 @@ extern uint16_t bend_offset;
 extern uint16_t bend_octave_width;
 extern uint32_t bend_halftone_width; // Q26.6
 extern uint8_t bend_depth;
+extern uint8_t bend_smoothing_bypass;  // 1 to apply bends immediately, 0 to interpolate
+
+#define MAX_BEND_DEPTH 24
 
 extern void UpdateBendDepth(uint8_t new_bend_depth);
+
+/**
+ * Sets the bend depth in semitones (0 to MAX_BEND_DEPTH) without saving it, e.g., by RPN 0
+ * from a DAW. The caller re-bends by the new depth.
+ */
+extern void SetBendDepth(uint8_t new_bend_depth);
 extern void BendPitch(int16_t bend_amount);
 
-extern void SetExpression(uint8_t value);
-extern void SetModulation(uint8_t value);
+/**
+ * Bends the pitch by a MIDI bend amount (-8192 to 8191) multiplied by a bend depth in
+ * semitones, for the callers that keep their own depths, e.g., the MPE member channels.
+ */
+extern void BendPitchBySemitones(int32_t semitone_amount);
+
+// Digital glide: the bend PWM starts at the note interval and ramps back to the bend position
+#define GLIDE_TICKS_PER_UNIT 468  // 10ms in PWM_Bend cycles
+#define MAX_GLIDE_TIME 200        // 2s
+extern uint8_t glide_time;        // in 10ms, 0 to use the analog portament instead
+
+/**
+ * Updates the glide time, up to MAX_GLIDE_TIME. The analog portament is turned off when
+ * the digital glide takes over.
+ *
+ * @param save - 1 to save the time to EEPROM, 0 if the caller saves it by the write-back
+ */
+extern void UpdateGlideTime(uint8_t new_glide_time, uint8_t save);
+
+/**
+ * Steps the bend smoother and the digital glide and dithers the bend out to PWM_Bend. Called by the PWM_Bend
+ * cycle interrupt handler.
+ */
+extern void BendHandleTick();
+
+/**
+ * Stops and restarts driving PWM_Bend from the interrupt handler, so that the
+ * calibration can write it directly. Resuming resets the bend to bend_offset.
+ */
+extern void SuspendBendDriver();
+extern void ResumeBendDriver();
+
+// Slew rates of the expression and modulation outputs in SLEW_RATE_UNIT DAC steps per
+// control tick, 0 for no limit
+#define SLEW_RATE_UNIT 4
+#define DEFAULT_SLEW_RATE 64
+extern uint8_t slew_rise;
+extern uint8_t slew_fall;
+
+/**
+ * Sets the expression or the modulation by a 14-bit MIDI control value. A 7-bit value
+ * comes as the MSB, i.e., shifted left by 7.
+ */
+extern void SetExpression(uint16_t value);
+extern void SetModulation(uint16_t value);
+
+/**
+ * Steps the LFO and moves the expression and modulation DACs toward the targets within
+ * the slew rates. Called by the PWM_Bend cycle interrupt handler at the control rate.
+ */
+extern void SlewHandleTick();
+
+/**
+ * Sets a channel or poly pressure value (0-127) to the expression or the modulation output
+ * if pressure_route in voice.h says so.
+ */
+extern void RoutePressure(uint8_t value);
+
+/**
+ * Sets portament time of the both voices by a MIDI control value (0-127).
+ */
+extern void SetPortamentTime(uint8_t value);
+
+/**
+ * Turns portament on (value >= 64) or off by a MIDI control value.
+ *
+ * The switch overrides the portament mode, see GetEffectivePortamentMode() in voice.h.
+ */
+extern void SetPortamentSwitch(uint8_t value);
+
+/**
+ * Releases the portament switch, so that the portament follows the portament mode again.
+ */
+extern void ResetPortamentSwitch();
+
+/**
+ * Sets the gate of a voice that outputs clock pulses. Called by the clock gates.
+ */
+extern void SetClockGate(uint8_t voice, uint8_t on);
 
 extern void InitializeVoiceControl();
 
+/**
+ * Commits the staged voice outputs. Called by the PWM_Bend cycle interrupt handler.
+ */
+extern void OutputFrameHandleTick();
+
 extern void BlinkGreen(uint16_t interval_ms, uint16_t times);
 extern void BlinkRed(uint16_t interval_ms, uint16_t times);
 
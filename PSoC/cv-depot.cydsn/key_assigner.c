@@ -33,56 +33,194 @@
 #include "voice.h"
 
 // We borrow PWM_Bend to count delay time, which has 21.354 usec cycle.
-// Gate should delay by about 10ms to avoid making sound during CV transition.
-#define GATE_DELAY 450
+// Gate should delay to avoid making sound during CV transition. The CV filter settles
+// exponentially, so the time to come within 10 cents of the new note grows with the
+// logarithm of the interval. The tables give the delay in 1/256 of gate_delay_max.
+#define GATE_DELAY_TICKS_PER_MS 47
+#define GATE_DELAY_MIN 2  // the CV is committed at the next tick
+static const uint8_t kGateDelayBySemitones[13] = {
+    0, 82, 107, 122, 132, 140, 147, 152, 157, 161, 165, 168, 171,
+};
+static const uint16_t kGateDelayByOctaves[11] = {
+    0, 171, 196, 211, 221, 229, 236, 241, 246, 250, 256,
+};
 
 voice_t all_voices[NUM_VOICES];
 
-static void SendGateOn(void *arg)
+// Checks if a time has come, taking the counter wrap into account
+#define TIME_REACHED(time) ((int32_t)(timer_counter - (time)) >= 0)
+
+/**
+ * Arms a gate edge of a voice. A gate-on cancels the pending gate-off that is not due
+ * before it, so that the gate of a legato change stays on. A gate-off due earlier is
+ * kept, so that a detached note struck again within the gate delay retriggers.
+ */
+static void ArmGate(voice_t *voice, uint8_t gate, uint32_t time)
 {
-    voice_t *voice =(voice_t *)arg;
-    uint32_t target_time;
-    if (voice->gate_on_time > TIMER_COUNTER_WRAP) {
-        CyGlobalIntDisable;
-        target_time = (timer_counter & (TIMER_COUNTER_WRAP - (TIMER_COUNTER_WRAP >> 1))) ? timer_counter : timer_counter + TIMER_COUNTER_WRAP + 1;
-        CyGlobalIntEnable;
+    uint8_t state = CyEnterCriticalSection();
+    if (gate) {
+        voice->gate_on_time = time;
+        voice->pending_gate |= GATE_EDGE_ON;
+        if ((int32_t)(voice->gate_off_time - time) >= 0) {
+            voice->pending_gate &= ~GATE_EDGE_OFF;
+        }
     } else {
-        target_time = timer_counter;
+        voice->gate_off_time = time;
+        voice->pending_gate |= GATE_EDGE_OFF;
     }
-    if (voice->gate_on_time > target_time) {
-        task_t task = { .run = SendGateOn, .arg = voice};
-        ScheduleTask(task);
-        return;
+    CyExitCriticalSection(state);
+}
+
+/**
+ * Queues a fired gate edge for KeyAssigner_NotifyGates. Called by the interrupt handler.
+ * A full queue drops its oldest edge, so that Analog3 ends up in the latest gate state.
+ */
+static void QueueGateEvent(voice_t *voice, uint8_t edge, uint8_t velocity)
+{
+    if ((uint8_t)(voice->gate_events_head - voice->gate_events_tail) == GATE_EVENT_QUEUE_SIZE) {
+        ++voice->gate_events_tail;
     }
-    voice->gate_on(voice->velocity);
-    CAN_DATA_BYTES_MSG data;
-    data.byte[0] = A3_VOICE_MSG_GATE_ON;
-    data.byte[1] = voice->velocity << 1;
-    data.byte[2] = 0;
-    A3SendDataStandard(A3_ID_MIDI_VOICE_BASE + voice->id, 3, &data);
+    volatile gate_event_t *event = &voice->gate_events[voice->gate_events_head & (GATE_EVENT_QUEUE_SIZE - 1)];
+    event->edge = edge;
+    event->velocity = velocity;
+    ++voice->gate_events_head;
 }
 
-static void SendGateOff(void *arg)
+static void SendGateMessage(voice_t *voice, uint8_t gate, uint8_t velocity)
 {
-    voice_t *voice =(voice_t *)arg;
-    uint32_t target_time;
-    if (voice->gate_off_time > TIMER_COUNTER_WRAP) {
-        CyGlobalIntDisable;
-        target_time = (timer_counter & (TIMER_COUNTER_WRAP - (TIMER_COUNTER_WRAP >> 1))) ? timer_counter : timer_counter + TIMER_COUNTER_WRAP + 1;
-        CyGlobalIntEnable;
+    CAN_DATA_BYTES_MSG data;
+    if (gate) {
+        data.byte[0] = A3_VOICE_MSG_GATE_ON;
+        data.byte[1] = velocity << 1;
+        data.byte[2] = 0;
+        A3SendDataStandard(A3_ID_MIDI_VOICE_BASE + voice->id, 3, &data);
     } else {
-        target_time = timer_counter;
+        data.byte[0] = A3_VOICE_MSG_GATE_OFF;
+        A3SendDataStandard(A3_ID_MIDI_VOICE_BASE + voice->id, 1, &data);
     }
-    if (voice->gate_off_time > target_time) {
-        task_t task = { .run = SendGateOff, .arg = voice};
-        ScheduleTask(task);
-        return;
+}
+
+void KeyAssigner_HandleTick()
+{
+    for (uint8_t i = 0; i < NUM_VOICES; ++i) {
+        voice_t *voice = &all_voices[i];
+        uint8_t pending = voice->pending_gate;
+        if (pending == 0) {
+            continue;
+        }
+        // Fire the edges in time order, at most one per tick, so that a retrigger
+        // keeps the gate low for a tick at least
+        uint8_t off_first = (pending & GATE_EDGE_OFF) &&
+            (!(pending & GATE_EDGE_ON) || (int32_t)(voice->gate_on_time - voice->gate_off_time) > 0);
+        if (off_first) {
+            if (TIME_REACHED(voice->gate_off_time)) {
+                voice->gate_off();
+                voice->pending_gate &= ~GATE_EDGE_OFF;
+                QueueGateEvent(voice, GATE_EDGE_OFF, 0);
+            }
+        } else if (TIME_REACHED(voice->gate_on_time)) {
+            voice->gate_on(voice->velocity);
+            voice->pending_gate &= ~GATE_EDGE_ON;
+            QueueGateEvent(voice, GATE_EDGE_ON, voice->velocity);
+        }
+    }
+}
+
+void KeyAssigner_NotifyGates()
+{
+    for (uint8_t i = 0; i < NUM_VOICES; ++i) {
+        voice_t *voice = &all_voices[i];
+        // send every edge in order, so that a short note fired between two passes
+        // is not lost
+        while (voice->gate_events_head != voice->gate_events_tail) {
+            uint8_t state = CyEnterCriticalSection();
+            gate_event_t event = voice->gate_events[voice->gate_events_tail & (GATE_EVENT_QUEUE_SIZE - 1)];
+            ++voice->gate_events_tail;
+            CyExitCriticalSection(state);
+            SendGateMessage(voice, event.edge == GATE_EDGE_ON, event.velocity);
+        }
+    }
+}
+
+void KeyAssigner_NotifyExpressions()
+{
+    for (uint8_t i = 0; i < NUM_VOICES; ++i) {
+        voice_t *voice = &all_voices[i];
+        // The unsigned elapsed time stays valid however long the voice has been idle
+        if ((voice->pressure_to_notify == 0 && !voice->bend_to_notify) ||
+            (uint32_t)(timer_counter - voice->expression_sent_time) < EXPRESSION_NOTIFY_TICKS) {
+            continue;
+        }
+        CAN_DATA_BYTES_MSG data;
+        if (voice->pressure_to_notify) {
+            data.byte[0] = voice->pressure_to_notify;
+            data.byte[1] = voice->pressure << 1;
+            data.byte[2] = 0;
+            A3SendDataStandard(A3_ID_MIDI_VOICE_BASE + voice->id, 3, &data);
+            voice->pressure_to_notify = 0;
+        }
+        if (voice->bend_to_notify) {
+            // 14 bits to 16 bits, the center is 0x8000
+            data.byte[0] = A3_VOICE_MSG_PITCH_BEND;
+            data.byte[1] = voice->bend >> 6;
+            data.byte[2] = (voice->bend << 2) & 0xff;
+            A3SendDataStandard(A3_ID_MIDI_VOICE_BASE + voice->id, 3, &data);
+            voice->bend_to_notify = 0;
+        }
+        voice->expression_sent_time = timer_counter;
+    }
+}
+
+/**
+ * Computes the gate delay of a note change in the timer ticks.
+ *
+ * @param voice - Voice to change the note
+ * @param note_number - New note
+ * @param glide - 1 if the change glides, in which case the gate does not wait for the CV
+ */
+static uint32_t GateDelay(const voice_t *voice, uint8_t note_number, uint8_t glide)
+{
+    if (glide) {
+        return GATE_DELAY_MIN;
+    }
+    uint16_t ratio = 256;
+    if (voice->cv_note != NOTE_UNSET) {
+        uint8_t interval = note_number > voice->cv_note ?
+            note_number - voice->cv_note : voice->cv_note - note_number;
+        if (interval <= 12) {
+            ratio = kGateDelayBySemitones[interval];
+        } else {
+            uint8_t octaves = (interval + 11) / 12;
+            ratio = kGateDelayByOctaves[octaves < 10 ? octaves : 10];
+        }
+    }
+    uint32_t delay = ((uint32_t)gate_delay_max * GATE_DELAY_TICKS_PER_MS * ratio) >> 8;
+    return delay > GATE_DELAY_MIN ? delay : GATE_DELAY_MIN;
+}
+
+/**
+ * Decides whether a note change glides.
+ *
+ * @param legato - 1 if the new note overlaps a held note
+ * @param note_on - 1 for a note-on, 0 for returning to a held note on a note-off
+ */
+static uint8_t ShouldGlide(uint8_t legato, uint8_t note_on)
+{
+    switch (GetEffectivePortamentMode()) {
+    case PORTAMENT_ALWAYS:
+        return 1;
+    case PORTAMENT_LEGATO:
+        return legato;
+    case PORTAMENT_FINGERED:
+        return legato && note_on;
+    default:
+        return 0;
     }
-    voice->gate_off();
 }
 
 void VoiceNoteOn(voice_t *voice, uint8_t note_number, uint8_t velocity)
 {
+    uint8_t glide = ShouldGlide(voice->num_notes > 0, 1);
     if (voice->num_notes == MAX_NOTES) {
         voice->in_use[voice->notes[MAX_NOTES-1]] = 0;
     } else {
@@ -93,19 +231,33 @@ void VoiceNoteOn(voice_t *voice, uint8_t note_number, uint8_t velocity)
     }
     voice->notes[0] = note_number;
 
-    // Update the hardware
+    // Update the hardware, all voices at once. The gate times are taken from a single
+    // reading of the counter, so that the voices of a unison change at the same tick.
+    uint32_t now = timer_counter;
+    HoldOutputFrame();
     for (voice_t *current = voice; current != NULL; current = current->next_voice) {
+        current->set_portament(glide);
         current->set_note(note_number);
+        // the interrupt handler takes the velocity as the gate rises
         current->velocity = velocity;
+        // Gate will rise some bend PWM cycles later so that the CV recipients
+        // can transit in the mean time.
+        current->gate_delay = GateDelay(current, note_number, glide);
+        uint32_t gate_on_time = now + current->gate_delay;
+        if ((current->pending_gate & GATE_EDGE_OFF) &&
+            (int32_t)(gate_on_time - current->gate_off_time) <= 0) {
+            // A detached note struck before the previous gate falls rises after it
+            gate_on_time = current->gate_off_time + GATE_DELAY_MIN;
+        }
+        ArmGate(current, 1, gate_on_time);
+        current->cv_note = note_number;
+    }
+    ReleaseOutputFrame();
+    for (voice_t *current = voice; current != NULL; current = current->next_voice) {
         CAN_DATA_BYTES_MSG data;
         data.byte[0] = A3_VOICE_MSG_SET_NOTE;
         data.byte[1] = note_number;
         A3SendDataStandard(A3_ID_MIDI_VOICE_BASE + current->id, 2, &data);
-        // Gate will rise GATE_DELAY bend PWM cycles later so that the CV recipients
-        // can transit in the mean time.
-        current->gate_on_time = timer_counter + GATE_DELAY;
-        task_t task = { .run = SendGateOn, .arg = current};
-        ScheduleTask(task);
     }
     // LED_Driver_PutChar7Seg('N', 0);
     // LED_Driver_Write7SegNumberHex(note_number, 1, 2, LED_Driver_RIGHT_ALIGN);
@@ -146,16 +298,21 @@ void VoiceNoteOff(voice_t *voice, uint8_t note_number)
     CAN_DATA_BYTES_MSG data;
     if (voice->num_notes == 0) {
         voice->gate = 0;
+        uint32_t now = timer_counter;
         for (voice_t *current = voice; current != NULL; current = current->next_voice) {
-            current->gate_off_time = timer_counter + GATE_DELAY;
-            task_t task = { .run = SendGateOff, .arg = current};
-            ScheduleTask(task);
-            data.byte[0] = A3_VOICE_MSG_GATE_OFF;
-            A3SendDataStandard(A3_ID_MIDI_VOICE_BASE + current->id, 1, &data);
+            // Gate falls as late as it rose, so that the gate keeps the note length
+            ArmGate(current, 0, now + current->gate_delay);
         }
     } else {
+        uint8_t glide = ShouldGlide(1, 0);
+        HoldOutputFrame();
         for (voice_t *current = voice; current != NULL; current = current->next_voice) {
+            current->set_portament(glide);
             current->set_note(voice->notes[0]);
+            current->cv_note = voice->notes[0];
+        }
+        ReleaseOutputFrame();
+        for (voice_t *current = voice; current != NULL; current = current->next_voice) {
             data.byte[0] = A3_VOICE_MSG_SET_NOTE;
             data.byte[1] = voice->notes[0];
             A3SendDataStandard(A3_ID_MIDI_VOICE_BASE + current->id, 2, &data);
@@ -164,19 +321,30 @@ void VoiceNoteOff(voice_t *voice, uint8_t note_number)
     }
 }
 
-static void InitializeVoice(voice_t *voice, uint8_t id,
-    void (*set_note)(uint8_t), void (*gate_on)(uint8_t), void (*gate_off)())
+static void InitializeVoice(voice_t *voice, uint8_t id, const voice_config_t *config)
 {
     voice->id = id;
     voice->num_notes = 0;
     voice->velocity = 0;
     voice->gate = 0;
+    voice->pending_gate = 0;
+    voice->gate_delay = GATE_DELAY_MIN;
+    voice->gate_events_head = 0;
+    voice->gate_events_tail = 0;
+    voice->cv_note = NOTE_UNSET;
+    voice->pressure = 0;
+    voice->pressure_to_notify = 0;
+    voice->bend = 0x2000;
+    voice->bend_to_notify = 0;
+    voice->expression_sent_time = timer_counter - EXPRESSION_NOTIFY_TICKS;
     for (int i = 0; i < ALL_NOTES; ++i) {
         voice->in_use[i] = 0;
     }
-    voice->set_note = set_note;
-    voice->gate_on = gate_on;
-    voice->gate_off = gate_off;
+    voice->set_note = config->set_note;
+    voice->gate_on = config->gate_on;
+    voice->gate_off = config->gate_off;
+    voice->set_portament = config->set_portament;
+    voice->set_pressure = config->set_pressure;
     voice->next_voice = NULL;
 }
 
@@ -185,8 +353,7 @@ void KeyAssigner_ConnectVoices()
     voice_config_t configs[NUM_VOICES];
     GetVoiceConfigs(configs, NUM_VOICES);
     for (uint8_t i = 0; i < NUM_VOICES; ++i) {
-        InitializeVoice(&all_voices[i], i,
-            configs[i].set_note, configs[i].gate_on, configs[i].gate_off);
+        InitializeVoice(&all_voices[i], i, &configs[i]);
     }
 }
 
@@ -251,4 +418,69 @@ void NoteOff(key_assigner_t *assigner, uint8_t note_number)
     }
 }
 
+static void SetPressure(voice_t *voice, uint8_t message, uint8_t value)
+{
+    voice->pressure = value;
+    voice->pressure_to_notify = message;
+    voice->set_pressure(value);
+}
+
+void ChannelPressure(key_assigner_t *key_assigner, uint8_t value)
+{
+    for (int i = 0; i < key_assigner->num_voices; ++i) {
+        for (voice_t *voice = key_assigner->voices[i]; voice != NULL; voice = voice->next_voice) {
+            SetPressure(voice, A3_VOICE_MSG_CHANNEL_PRESSURE, value);
+        }
+    }
+}
+
+void PolyKeyPressure(key_assigner_t *key_assigner, uint8_t note_number, uint8_t value)
+{
+    for (int i = 0; i < key_assigner->num_voices; ++i) {
+        // the first voice of a unison chain keeps the gate
+        voice_t *voice = key_assigner->voices[i];
+        if (!voice->gate || voice->cv_note != note_number) {
+            continue;
+        }
+        for (; voice != NULL; voice = voice->next_voice) {
+            SetPressure(voice, A3_VOICE_MSG_POLY_KEY_PRESSURE, value);
+        }
+    }
+}
+
+uint8_t IsNoteSounding(key_assigner_t *key_assigner, const voice_t *voice, uint8_t note_number)
+{
+    for (int i = 0; i < key_assigner->num_voices; ++i) {
+        // the first voice of a unison chain keeps the gate
+        const voice_t *first = key_assigner->voices[i];
+        for (const voice_t *current = first; current != NULL; current = current->next_voice) {
+            if (current == voice) {
+                return first->gate && first->cv_note == note_number;
+            }
+        }
+    }
+    return 0;
+}
+
+void VoicePitchBend(key_assigner_t *key_assigner, uint16_t value)
+{
+    for (int i = 0; i < key_assigner->num_voices; ++i) {
+        for (voice_t *voice = key_assigner->voices[i]; voice != NULL; voice = voice->next_voice) {
+            voice->bend = value;
+            voice->bend_to_notify = 1;
+        }
+    }
+}
+
+void AllNotesOff(key_assigner_t *key_assigner)
+{
+    for (int i = 0; i < key_assigner->num_voices; ++i) {
+        voice_t *voice = key_assigner->voices[i];
+        // drop the hidden notes first so that the voice does not fall back to them
+        while (voice->num_notes > 0) {
+            VoiceNoteOff(voice, voice->notes[voice->num_notes - 1]);
+        }
+    }
+}
+
 /* [] END OF FILE */
@@ -31,6 +31,19 @@
 #define MAX_TRACK_HISTORY 8
 #define ALL_NOTES 128
 #define NUM_VOICES 2
+#define NOTE_UNSET 0xff
+
+// Gate edges
+#define GATE_EDGE_ON 0x01
+#define GATE_EDGE_OFF 0x02
+
+// Fired gate edges waiting for the main loop to send them over CAN, a power of 2
+#define GATE_EVENT_QUEUE_SIZE 8
+
+typedef struct gate_event {
+    uint8_t edge;
+    uint8_t velocity;  // taken as the gate rises
+} gate_event_t;
 
 enum KeyAssignmentMode {
     KEY_ASSIGN_DUOPHONIC = 0,
@@ -55,9 +68,22 @@ typedef struct voice {
     uint8_t in_use[ALL_NOTES];
     uint32_t gate_on_time;
     uint32_t gate_off_time;
+    uint32_t gate_delay;  // delay of the latest gate-on, applied to the gate-off too
+    volatile uint8_t pending_gate;    // armed gate edges, fired by the timer interrupt
+    volatile gate_event_t gate_events[GATE_EVENT_QUEUE_SIZE];
+    volatile uint8_t gate_events_head;  // advanced by the interrupt handler
+    volatile uint8_t gate_events_tail;  // advanced by the main loop
+    uint8_t cv_note;  // note on the CV output, NOTE_UNSET if unknown
+    uint8_t pressure;
+    uint8_t pressure_to_notify;  // A3 message type of the pressure to send, 0 if none
+    uint16_t bend;               // 14-bit MIDI pitch bend of the voice's own channel
+    uint8_t bend_to_notify;
+    uint32_t expression_sent_time;  // timer_counter at the latest expression notification
     void (*set_note)(uint8_t note_number);
     void (*gate_on)(uint8_t velocity);
     void (*gate_off)();
+    void (*set_portament)(uint8_t on);
+    void (*set_pressure)(uint8_t value);
     struct voice *next_voice;
 } voice_t;
 
@@ -87,8 +113,46 @@ extern key_assigner_t *InitializeKeyAssigner(key_assigner_t *, enum KeyPriority)
 //   InitializeKeyAssigner as the mode must be consistent in an assigner.
 extern void AddVoice(key_assigner_t *, voice_t *, enum KeyAssignmentMode);
 
+/**
+ * Fires the armed gate edges that are due. Called by the PWM_Bend cycle interrupt handler,
+ * so that the gates change at the exact ticks.
+ */
+extern void KeyAssigner_HandleTick();
+
+/**
+ * Sends the gate edges fired by the interrupt handler to Analog3. Called by the main loop.
+ */
+extern void KeyAssigner_NotifyGates();
+
+/**
+ * Sends the latest pressures and per-voice bends to Analog3, at most once per
+ * EXPRESSION_NOTIFY_TICKS per voice so that the streams cannot crowd the notes off the bus.
+ * Called by the main loop.
+ */
+#define EXPRESSION_NOTIFY_TICKS 468  // 10ms
+extern void KeyAssigner_NotifyExpressions();
+
 // Requests for performance actions
 extern void NoteOn(key_assigner_t *key_assigner, uint8_t note_number, uint8_t velocity);
 extern void NoteOff(key_assigner_t *key_assigner, uint8_t note_number);
+extern void ChannelPressure(key_assigner_t *key_assigner, uint8_t value);
+extern void PolyKeyPressure(key_assigner_t *key_assigner, uint8_t note_number, uint8_t value);
+
+/**
+ * Returns 1 if a note of a key assigner is sounding on a voice, e.g., to route the poly
+ * key pressure of that note only to the outputs that follow the voice.
+ */
+extern uint8_t IsNoteSounding(key_assigner_t *key_assigner, const voice_t *voice, uint8_t note_number);
+
+/**
+ * Sets a 14-bit pitch bend to the voices of a key assigner, forwarded to Analog3 only. The
+ * bend output is driven by the MIDI decoder.
+ */
+extern void VoicePitchBend(key_assigner_t *key_assigner, uint16_t value);
+
+/**
+ * Releases all notes of a key assigner, e.g., before its voice is handed to another channel.
+ */
+extern void AllNotesOff(key_assigner_t *key_assigner);
 
 /* [] END OF FILE */
@@ -0,0 +1,128 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2025 Naoki Iwakami
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "project.h"
+
+#include "eeprom.h"
+#include "lfo.h"
+#include "main.h"
+#include "midi_clock.h"
+
+// Phase increment per control tick for 0.1Hz: 2^32 / (10 x 996.4Hz)
+#define PHASE_INCREMENT_PER_RATE 431070
+
+// Phase increment of a synced cycle is (2^32 x 256 x CONTROL_TICK_DIVIDER) / (period x lfo_sync)
+#define SYNC_INCREMENT_NUMERATOR ((uint64_t)CONTROL_TICK_DIVIDER << 40)
+
+// The phase follows 1/4 of the error at every clock
+#define PHASE_GAIN_SHIFT 2
+
+uint8_t lfo_wave;
+uint8_t lfo_rate;
+uint8_t lfo_sync;
+
+static uint32_t phase;
+static volatile uint32_t sync_increment;  // 0 until the tempo is known
+static uint8_t held_value;                // sample and hold
+static uint16_t noise = 0xace1;           // LFSR
+
+// One cycle of the sine, starting at the bottom
+static const uint8_t kSineTable[64] = {
+      0,   1,   2,   5,  10,  15,  21,  29,  37,  47,  57,  67,  79,  90, 103, 115,
+    127, 140, 152, 165, 176, 188, 198, 208, 218, 226, 234, 240, 245, 250, 253, 254,
+    255, 254, 253, 250, 245, 240, 234, 226, 218, 208, 198, 188, 176, 165, 152, 140,
+    128, 115, 103,  90,  79,  67,  57,  47,  37,  29,  21,  15,  10,   5,   2,   1,
+};
+
+void InitializeLfo()
+{
+    lfo_wave = ReadEepromWithValueCheck(ADDR_LFO_WAVE, LFO_WAVE_END);
+    lfo_rate = EEPROM_ReadByte(ADDR_LFO_RATE);
+    if (lfo_rate == 0xff) {
+        lfo_rate = DEFAULT_LFO_RATE;
+    }
+    lfo_sync = ReadEepromWithValueCheck(ADDR_LFO_SYNC, 0xff);
+    phase = 0;
+    sync_increment = 0;
+    held_value = 0;
+}
+
+static uint8_t Noise()
+{
+    // 16-bit Galois LFSR
+    noise = (noise >> 1) ^ (-(noise & 1) & 0xb400);
+    return noise;
+}
+
+static uint8_t Sine(uint32_t p)
+{
+    uint8_t index = p >> 26;
+    int16_t y0 = kSineTable[index];
+    int16_t y1 = kSineTable[(index + 1) & 0x3f];
+    uint8_t fraction = p >> 18;
+    return y0 + (((y1 - y0) * fraction) >> 8);
+}
+
+uint8_t LfoHandleTick()
+{
+    uint32_t increment = lfo_sync && sync_increment ? sync_increment : lfo_rate * PHASE_INCREMENT_PER_RATE;
+    uint32_t previous = phase;
+    phase += increment;
+    switch (lfo_wave) {
+    case LFO_TRIANGLE: {
+        uint16_t t = phase >> 23;
+        return t < 256 ? t : 511 - t;
+    }
+    case LFO_SINE:
+        return Sine(phase);
+    case LFO_SAW:
+        return phase >> 24;
+    case LFO_SQUARE:
+        return phase < 0x80000000 ? 0xff : 0;
+    case LFO_SAMPLE_AND_HOLD:
+        if (phase < previous) {
+            // a new cycle
+            held_value = Noise();
+        }
+        return held_value;
+    default:
+        return 0;
+    }
+}
+
+void LfoHandleClock(uint32_t index)
+{
+    if (lfo_sync == 0 || !midi_clock.locked || midi_clock.period == 0) {
+        return;
+    }
+    sync_increment = SYNC_INCREMENT_NUMERATOR / ((uint64_t)midi_clock.period * lfo_sync);
+
+    // pull the phase toward the position in the cycle
+    uint32_t expected = ((uint64_t)(index % lfo_sync) << 32) / lfo_sync;
+    uint8_t state = CyEnterCriticalSection();
+    phase += (int32_t)(expected - phase) >> PHASE_GAIN_SHIFT;
+    CyExitCriticalSection(state);
+}
+
+/* [] END OF FILE */
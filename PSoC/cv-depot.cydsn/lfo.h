@@ -0,0 +1,72 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2025 Naoki Iwakami
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * LFO of the modulation output.
+ *
+ * A phase accumulator steps at the control rate and shapes the output by arithmetic or a
+ * small wavetable. The rate runs free, or follows the MIDI clock when synced. The
+ * modulation wheel (CC1) sets the depth, see SlewHandleTick() in hardware.c.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+enum LfoWave {
+    LFO_OFF = 0,  // CC1 drives the modulation output directly
+    LFO_TRIANGLE,
+    LFO_SINE,
+    LFO_SAW,
+    LFO_SQUARE,
+    LFO_SAMPLE_AND_HOLD,
+    LFO_WAVE_END,
+};
+
+extern uint8_t lfo_wave;
+extern uint8_t lfo_rate;  // free running rate in 0.1Hz
+extern uint8_t lfo_sync;  // MIDI clocks per cycle when synced, 0 to run free
+
+#define DEFAULT_LFO_RATE 50  // 5Hz
+
+/**
+ * Loads the LFO settings from EEPROM.
+ */
+extern void InitializeLfo();
+
+/**
+ * Steps the LFO. Called at the control rate by the PWM_Bend cycle interrupt handler.
+ *
+ * @returns uint8_t: Output level 0-255
+ */
+extern uint8_t LfoHandleTick();
+
+/**
+ * Follows the tempo and the position of a MIDI clock while running.
+ *
+ * @param index - Position of the clock since the start
+ */
+extern void LfoHandleClock(uint32_t index);
+
+/* [] END OF FILE */
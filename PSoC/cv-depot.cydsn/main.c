@@ -27,7 +27,9 @@
 #include "project.h"
 
 #include "analog3.h"
+#include "clock_gate.h"
 #include "eeprom.h"
+#include "envelope.h"
 #include "key_assigner.h"
 #include "main.h"
 #include "midi.h"
@@ -104,6 +106,11 @@ int main(void)
     LED_Driver_SetBrightness(LED_Driver_BRIGHTNESS, 1);
     LED_Driver_SetBrightness(LED_Driver_BRIGHTNESS, 2);
     isr_SW_StartEx(SwitchHandler);
+#ifdef MEASURE_COUNTER_HANDLER
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
     isr_COUNT_StartEx(CounterHandler);
     QuadDec_Start();
 
@@ -127,8 +134,9 @@ int main(void)
         if (mode != MODE_NORMAL) {
             HandleSettingModes();
         }
-        // Consume pot change requests if not empty
-        PotChangeHandleRequests();
+        KeyAssigner_NotifyGates();
+        KeyAssigner_NotifyExpressions();
+        EepromWriteBackTask();
 
         // Consume task if any, one at a time
         ConsumeTask();
@@ -142,11 +150,63 @@ CY_ISR(SwitchHandler)
     HandleSwitchEvent();
 }
 
-uint32_t timer_counter = 0;
+#ifdef MEASURE_COUNTER_HANDLER
+// CPU cycles spent by CounterHandler, to be watched by the debugger. The handler has to
+// finish well within a PWM_Bend cycle. The total over the cycle counter gives the CPU load.
+volatile uint32_t counter_handler_cycles;
+volatile uint32_t counter_handler_max_cycles;
+volatile uint64_t counter_handler_total_cycles;
+// The control rate stages run in the same handler, every CONTROL_TICK_DIVIDER cycles.
+volatile uint32_t control_tick_max_cycles;
+#endif
+
+volatile uint32_t timer_counter = 0;
+static uint8_t control_divider = 0;
+
+// The handler runs every PWM_Bend cycle as it dithers the bend and times the gates and the
+// pots. Each stage returns early when it has nothing to do.
 CY_ISR(CounterHandler)
 {
+#ifdef MEASURE_COUNTER_HANDLER
+    uint32_t entry_cycles = DWT->CYCCNT;
+#endif
     PWM_Bend_ReadStatusRegister();
-    timer_counter = (timer_counter + 1) & TIMER_COUNTER_WRAP;
+    ++timer_counter;
+
+    // Voice outputs change at the tick boundary
+    KeyAssigner_HandleTick();
+    ClockGateHandleTick();
+    OutputFrameHandleTick();
+
+    // Step the pots at a fixed rate
+    PotChangeHandleRequests();
+
+    BendHandleTick();
+
+    // Control rate processing
+    if (++control_divider == CONTROL_TICK_DIVIDER) {
+        control_divider = 0;
+#ifdef MEASURE_COUNTER_HANDLER
+        uint32_t control_cycles = DWT->CYCCNT;
+#endif
+        SlewHandleTick();
+        EnvelopeHandleTick();
+#ifdef MEASURE_COUNTER_HANDLER
+        control_cycles = DWT->CYCCNT - control_cycles;
+        if (control_cycles > control_tick_max_cycles) {
+            control_tick_max_cycles = control_cycles;
+        }
+#endif
+    }
+
+#ifdef MEASURE_COUNTER_HANDLER
+    uint32_t cycles = DWT->CYCCNT - entry_cycles;
+    counter_handler_cycles = cycles;
+    counter_handler_total_cycles += cycles;
+    if (cycles > counter_handler_max_cycles) {
+        counter_handler_max_cycles = cycles;
+    }
+#endif
 }
 
 #ifdef CAN_MSG_RX_ISR_CALLBACK
@@ -42,6 +42,10 @@ enum ProgramMode {
     MODE_BEND_DEPTH_CONFIRMED,
     MODE_EXPRESSION_SETUP,
     MODE_EXPRESSION_CONFIRMED,
+    MODE_PORTAMENT_SETUP,
+    MODE_PORTAMENT_CONFIRMED,
+    MODE_GATE_OUTPUT_SETUP,
+    MODE_GATE_OUTPUT_CONFIRMED,
     MODE_CALIBRATION_INIT,
     MODE_CALIBRATION_BEND_WIDTH,
     MODE_CALIBRATION_BEND_CONFIRMED,
@@ -59,7 +63,11 @@ typedef struct task {
 
 extern void ScheduleTask(task_t task);
 
-#define TIMER_COUNTER_WRAP 0x7fffffff
-extern uint32_t timer_counter;
+// Timer ticks of PWM_Bend cycles. The counter wraps around at 2^32, compare the times by
+// the signed difference, e.g., (int32_t)(timer_counter - time) >= 0.
+extern volatile uint32_t timer_counter;
+
+// Control rate processing runs every CONTROL_TICK_DIVIDER PWM_Bend cycles, about 1kHz
+#define CONTROL_TICK_DIVIDER 47
 
 /* [] END OF FILE */
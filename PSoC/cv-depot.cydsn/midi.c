@@ -27,8 +27,11 @@
 #include "project.h"
 
 #include "eeprom.h"
+#include "config.h"
 #include "hardware.h"
 #include "midi.h"
+#include "midi_clock.h"
+#include "sysex.h"
 #include "key_assigner.h"
 
 /*---------------------------------------------------------*/
@@ -52,8 +55,21 @@ midi_config_t midi_config;
 /* MIDI Control Changes */
 #define CC_WHEEL                 0x01
 #define CC_BREATH                0x02
+#define CC_PORTAMENTO_TIME       0x05
 #define CC_EXPRESSION            0x0B
+#define CC_WHEEL_LSB             0x21
+#define CC_BREATH_LSB            0x22
+#define CC_EXPRESSION_LSB        0x2B
+#define CC_DATA_ENTRY            0x06
+#define CC_DATA_ENTRY_LSB        0x26
+#define CC_DATA_INCREMENT        0x60
+#define CC_DATA_DECREMENT        0x61
+#define CC_NRPN_LSB              0x62
+#define CC_NRPN_MSB              0x63
+#define CC_RPN_LSB               0x64
+#define CC_RPN_MSB               0x65
 #define CC_DAMPER_PEDAL          0x40
+#define CC_PORTAMENTO            0x41
 
 /* MIDI Channel Mode Messages */
 #define CC_ALL_SOUND_OFF         0x78
@@ -79,6 +95,11 @@ midi_config_t midi_config;
 #define C4 0x3C
 #define A4 0x45
 
+/* Registered parameters */
+#define RPN_PITCH_BEND_SENSITIVITY 0x0000
+#define RPN_MPE_CONFIGURATION      0x0006
+#define RPN_NULL                   0x3FFF
+
 /* Bend */
 #define BEND_CENTER 8192
 #define BEND_FULL 8192
@@ -103,10 +124,57 @@ static uint8_t midi_data[2];        // MIDI data buffer
 static uint8_t midi_data_position;  // MIDI data buffer pointer
 static uint8_t midi_data_length;    // Expected MIDI data length
 
+// 14-bit controllers. An LSB refines the latest MSB, and a new MSB clears the LSB, so
+// 7-bit senders work as before.
+enum HighResController {
+    HIGH_RES_WHEEL = 0,
+    HIGH_RES_BREATH,
+    HIGH_RES_EXPRESSION,
+    NUM_HIGH_RES_CONTROLLERS,
+};
+static uint8_t high_res_msb[NUM_HIGH_RES_CONTROLLERS];
+
+// Parameter selected by RPN or NRPN for the data entry, per channel as the selection and
+// the data entry of a channel must not disturb the others. NRPN numbers are the config
+// property IDs.
+enum ParameterType {
+    PARAMETER_NONE = 0,
+    PARAMETER_RPN,
+    PARAMETER_NRPN,
+};
+static struct parameter_state {
+    uint8_t type;
+    uint16_t number;
+    uint8_t data_msb;
+    uint8_t data_lsb;
+} parameters[NUM_MIDI_CHANNELS];
+
 static key_assigner_t key_assigner_instances[2];
 static key_assigner_t *key_assigners[NUM_MIDI_CHANNELS];
 
+// MPE zone. Each voice has its own key assigner, and a member channel is bound to a voice
+// at note-on by pointing key_assigners[] at the assigner of the voice, so the channel lookup
+// stays a table access. The bend output goes with the first voice, which the digital glide
+// drives too.
+enum MpeChannelRole {
+    MPE_NONE = 0,
+    MPE_MASTER,
+    MPE_MEMBER,
+};
+#define CHANNEL_UNBOUND 0xff
+static uint8_t mpe_channel_roles[NUM_MIDI_CHANNELS];
+static struct mpe_state {
+    uint8_t voice_channels[NUM_VOICES];       // member channel bound to each voice
+    uint8_t next_voice;                       // voice to bind next, in the binding order
+    int16_t master_bend;
+    uint8_t member_bend_depth;                // the master channel uses bend_depth
+    int16_t channel_bends[NUM_MIDI_CHANNELS];     // latest bends of the member channels
+    uint8_t channel_pressures[NUM_MIDI_CHANNELS];
+} mpe;
+static int16_t last_bend_amount;  // latest pitch bend out of an MPE zone, re-applied on a depth change
+
 static void HandleMidiChannelMessage();
+static void BendFirstMpeVoice();
 
 void InitializeMidiControllers()
 {
@@ -119,6 +187,9 @@ void InitializeMidiControllers()
     midi_config.key_priority =
         ReadEepromWithValueCheck(ADDR_KEY_PRIORITY, KEY_PRIORITY_END);
     midi_config.expression_or_breath = ReadEepromWithValueCheck(ADDR_EXPRESSION_OR_BREATH, 2);
+    midi_config.mpe_zone = ReadEepromWithValueCheck(ADDR_MPE_ZONE, MPE_ZONE_END);
+    midi_config.mpe_member_channels = MAX_MPE_MEMBER_CHANNELS;
+    InitializeMidiClock();
 
     // set A4 to all voices and turn off gates
     for (int i = 0; i < NUM_VOICES; ++i) {
@@ -137,7 +208,51 @@ void InitializeMidiDecoder()
     midi_data_position = 0;
     midi_data_length = 0;
 
+    AssignMidiChannels();
+}
+
+static void AssignMpeZone()
+{
+    for (uint8_t i = 0; i < NUM_VOICES; ++i) {
+        InitializeKeyAssigner(&key_assigner_instances[i], midi_config.key_priority);
+        AddVoice(&key_assigner_instances[i], &all_voices[i], KEY_ASSIGN_PARALLEL);
+        mpe.voice_channels[i] = CHANNEL_UNBOUND;
+    }
+    mpe.next_voice = 0;
+    mpe.master_bend = 0;
+    mpe.member_bend_depth = DEFAULT_MPE_MEMBER_BEND_DEPTH;
+    memset(mpe.channel_bends, 0, sizeof(mpe.channel_bends));
+    memset(mpe.channel_pressures, 0, sizeof(mpe.channel_pressures));
+
+    uint8_t members = midi_config.mpe_member_channels;
+    if (members > MAX_MPE_MEMBER_CHANNELS) {
+        members = MAX_MPE_MEMBER_CHANNELS;
+    }
+    uint8_t first_member = 1;
+    if (midi_config.mpe_zone == MPE_ZONE_UPPER) {
+        mpe_channel_roles[NUM_MIDI_CHANNELS - 1] = MPE_MASTER;
+        first_member = NUM_MIDI_CHANNELS - 1 - members;
+    } else {
+        mpe_channel_roles[0] = MPE_MASTER;
+    }
+    for (uint8_t i = 0; i < members; ++i) {
+        mpe_channel_roles[first_member + i] = MPE_MEMBER;
+    }
+}
+
+void AssignMidiChannels()
+{
+    // release the notes held by the old assignment
+    for (uint8_t i = 0; i < NUM_VOICES; ++i) {
+        AllNotesOff(&key_assigner_instances[i]);
+    }
     memset(key_assigners, 0, sizeof(key_assigners));
+    memset(mpe_channel_roles, MPE_NONE, sizeof(mpe_channel_roles));
+
+    if (midi_config.mpe_zone != MPE_ZONE_OFF) {
+        AssignMpeZone();
+        return;
+    }
 
     // TODO: Generalize the implementation for N number of voices
     key_assigners[midi_config.channels[0]] =
@@ -163,17 +278,17 @@ void CommitMidiConfigChange(const midi_config_t *new_config)
     EEPROM_UpdateTemperature();
     for (int voice = 0; voice < NUM_VOICES; ++voice) {
         if (new_config->channels[voice] != midi_config.channels[voice]) {
-            EEPROM_WriteByte(new_config->channels[voice], ADDR_MIDI_CH_1 + voice);
+            Save8(new_config->channels[voice], ADDR_MIDI_CH_1 + voice);
         }
     }
     if (new_config->key_assignment_mode != midi_config.key_assignment_mode) {
-        EEPROM_WriteByte(new_config->key_assignment_mode, ADDR_KEY_ASSIGNMENT_MODE);
+        Save8(new_config->key_assignment_mode, ADDR_KEY_ASSIGNMENT_MODE);
     }
     if (new_config->key_priority != midi_config.key_priority) {
-        EEPROM_WriteByte(new_config->key_priority, ADDR_KEY_PRIORITY);
+        Save8(new_config->key_priority, ADDR_KEY_PRIORITY);
     }
     if (new_config->expression_or_breath != midi_config.expression_or_breath) {
-        EEPROM_WriteByte(new_config->key_priority, ADDR_EXPRESSION_OR_BREATH);
+        Save8(new_config->key_priority, ADDR_EXPRESSION_OR_BREATH);
     }
 
     // Reflect changes
@@ -184,20 +299,31 @@ void CommitMidiConfigChange(const midi_config_t *new_config)
 void ConsumeMidiByte(uint8_t rx_byte)
 {
     if (rx_byte >= TIMINIG_CLOCK) {
-      // Ignore system real-time messages (yet)
-      return;
+        // System real-time messages may come anywhere, handle them without touching
+        // the decoder state
+        HandleMidiRealTime(rx_byte);
+        return;
     }
 
-    // Ignore system messages
     if (IsInSystemExclusiveMode(midi_status)) {
+        if (rx_byte <= MAX_DATA_VALUE) {
+            SysExConsume(rx_byte);
+            return;
+        }
+        // F7 or any other status byte ends the message
+        SysExEnd();
+        midi_status = SYSEX_OUT;
         if (rx_byte == SYSEX_OUT) {
-            midi_status = SYSEX_OUT;
+            return;
         }
-        return;
     }
 
+    // Ignore system common messages other than system exclusive
     if (rx_byte >= SYSEX_IN) {
         midi_status = rx_byte;
+        if (rx_byte == SYSEX_IN) {
+            SysExStart();
+        }
         return;
     }
 
@@ -239,31 +365,389 @@ void ConsumeMidiByte(uint8_t rx_byte)
     }
 }
 
-void ControlChange(uint8_t controller_number, uint8_t value)
+static void SetHighResController(enum HighResController controller, uint16_t value)
 {
-    switch (controller_number) {
-    case CC_WHEEL:
+    switch (controller) {
+    case HIGH_RES_WHEEL:
         SetModulation(value);
         break;
-    case CC_EXPRESSION:
+    case HIGH_RES_BREATH:
+        if (midi_config.expression_or_breath == 1) {
+            SetExpression(value);
+        }
+        break;
+    default:
         if (midi_config.expression_or_breath == 0) {
             SetExpression(value);
         }
         break;
+    }
+}
+
+static void HighResMsb(enum HighResController controller, uint8_t value)
+{
+    high_res_msb[controller] = value;
+    SetHighResController(controller, value << 7);
+}
+
+static void HighResLsb(enum HighResController controller, uint8_t value)
+{
+    SetHighResController(controller, (high_res_msb[controller] << 7) | value);
+}
+
+static void SelectParameter(
+    struct parameter_state *parameter, enum ParameterType type, uint8_t msb, uint8_t value)
+{
+    if (parameter->type != type) {
+        parameter->number = RPN_NULL;
+    }
+    parameter->type = type;
+    if (msb) {
+        parameter->number = (parameter->number & 0x7f) | (value << 7);
+    } else {
+        parameter->number = (parameter->number & 0x3f80) | value;
+    }
+    if (type == PARAMETER_RPN && parameter->number == RPN_NULL) {
+        parameter->type = PARAMETER_NONE;
+    }
+}
+
+/**
+ * Sets up an MPE zone by the MPE configuration message, which comes on the master channel
+ * of the zone. The zone is not saved, as the controller sends it again on connection.
+ *
+ * @param members - Number of the member channels, 0 to turn the zone off
+ */
+static void ConfigureMpeZone(uint8_t members)
+{
+    uint8_t zone;
+    if (midi_channel == 0) {
+        zone = MPE_ZONE_LOWER;
+    } else if (midi_channel == NUM_MIDI_CHANNELS - 1) {
+        zone = MPE_ZONE_UPPER;
+    } else {
+        return;
+    }
+    if (members == 0) {
+        if (midi_config.mpe_zone != zone) {
+            return;
+        }
+        zone = MPE_ZONE_OFF;
+    }
+    midi_config.mpe_zone = zone;
+    midi_config.mpe_member_channels = members ? members : MAX_MPE_MEMBER_CHANNELS;
+    AssignMidiChannels();
+}
+
+/**
+ * Sets the bend depth of the current channel. The member channels of an MPE zone share a
+ * depth of their own, the others set the master depth.
+ */
+static void SetChannelBendDepth(int16_t depth)
+{
+    if (mpe_channel_roles[midi_channel] != MPE_MEMBER) {
+        SetBendDepth(depth < 0 ? 0 : depth);
+        // re-bend by the new depth at once, not at the next pitch bend
+        if (mpe_channel_roles[midi_channel] == MPE_MASTER) {
+            BendFirstMpeVoice();
+        } else {
+            BendPitch(last_bend_amount);
+        }
+        return;
+    }
+    if (depth < 0) {
+        depth = 0;
+    } else if (depth > MAX_MPE_MEMBER_BEND_DEPTH) {
+        depth = MAX_MPE_MEMBER_BEND_DEPTH;
+    }
+    mpe.member_bend_depth = depth;
+    BendFirstMpeVoice();
+}
+
+/**
+ * Applies the data entry to the selected parameter. RPNs take effect by the MSB. An NRPN
+ * takes the MSB as the value, so that 7-bit senders work, and an LSB that follows refines
+ * it to 14 bits of the MSB and the LSB, clamped to 255.
+ */
+static void ApplyParameter(struct parameter_state *parameter, uint8_t has_lsb)
+{
+    if (parameter->type == PARAMETER_RPN) {
+        if (parameter->number == RPN_PITCH_BEND_SENSITIVITY) {
+            // semitones, the cents in the LSB are not supported
+            SetChannelBendDepth(parameter->data_msb);
+        } else if (parameter->number == RPN_MPE_CONFIGURATION && !has_lsb) {
+            ConfigureMpeZone(parameter->data_msb);
+        }
+        return;
+    }
+    if (parameter->type != PARAMETER_NRPN || parameter->number >= NUM_PROPS) {
+        return;
+    }
+    a3_property_t *prop = &config[parameter->number];
+    if (prop->value_type != A3_U8) {
+        return;
+    }
+    uint16_t value = has_lsb ? (parameter->data_msb << 7) | parameter->data_lsb : parameter->data_msb;
+    uint8_t data = value > 0xff ? 0xff : value;
+    CommitPropertyUnsaved(prop, &data, 1);
+}
+
+static void StepParameter(struct parameter_state *parameter, int8_t step)
+{
+    if (parameter->type == PARAMETER_RPN) {
+        if (parameter->number == RPN_PITCH_BEND_SENSITIVITY) {
+            // by semitone
+            uint8_t depth =
+                mpe_channel_roles[midi_channel] == MPE_MEMBER ? mpe.member_bend_depth : bend_depth;
+            SetChannelBendDepth(depth + step);
+        }
+    } else if (parameter->type == PARAMETER_NRPN && parameter->number < NUM_PROPS) {
+        a3_property_t *prop = &config[parameter->number];
+        if (prop->value_type != A3_U8) {
+            return;
+        }
+        uint8_t data = *(uint8_t *)prop->data + step;
+        if ((step > 0 && data == 0) || (step < 0 && data == 0xff)) {
+            // saturate
+            return;
+        }
+        CommitPropertyUnsaved(prop, &data, 1);
+    }
+}
+
+void ControlChange(uint8_t controller_number, uint8_t value)
+{
+    struct parameter_state *parameter = &parameters[midi_channel];
+    switch (controller_number) {
+    case CC_WHEEL:
+        HighResMsb(HIGH_RES_WHEEL, value);
+        break;
+    case CC_EXPRESSION:
+        HighResMsb(HIGH_RES_EXPRESSION, value);
+        break;
     case CC_BREATH:
-        if (midi_config.expression_or_breath == 1) {
-            SetExpression(value);
+        HighResMsb(HIGH_RES_BREATH, value);
+        break;
+    case CC_WHEEL_LSB:
+        HighResLsb(HIGH_RES_WHEEL, value);
+        break;
+    case CC_EXPRESSION_LSB:
+        HighResLsb(HIGH_RES_EXPRESSION, value);
+        break;
+    case CC_BREATH_LSB:
+        HighResLsb(HIGH_RES_BREATH, value);
+        break;
+    case CC_RPN_MSB:
+        SelectParameter(parameter, PARAMETER_RPN, 1, value);
+        break;
+    case CC_RPN_LSB:
+        SelectParameter(parameter, PARAMETER_RPN, 0, value);
+        break;
+    case CC_NRPN_MSB:
+        SelectParameter(parameter, PARAMETER_NRPN, 1, value);
+        break;
+    case CC_NRPN_LSB:
+        SelectParameter(parameter, PARAMETER_NRPN, 0, value);
+        break;
+    case CC_DATA_ENTRY:
+        parameter->data_msb = value;
+        parameter->data_lsb = 0;
+        ApplyParameter(parameter, 0);
+        break;
+    case CC_DATA_ENTRY_LSB:
+        parameter->data_lsb = value;
+        ApplyParameter(parameter, 1);
+        break;
+    case CC_DATA_INCREMENT:
+        StepParameter(parameter, 1);
+        break;
+    case CC_DATA_DECREMENT:
+        StepParameter(parameter, -1);
+        break;
+    case CC_PORTAMENTO_TIME:
+        SetPortamentTime(value);
+        break;
+    case CC_PORTAMENTO:
+        SetPortamentSwitch(value);
+        break;
+    case CC_RESET_ALL_CONTROLLERS:
+        ResetPortamentSwitch();
+        break;
+    }
+}
+
+/**
+ * Binds the current channel to a voice for a note-on. A voice without a gate is preferred,
+ * otherwise the voice bound the earliest is taken over.
+ */
+static key_assigner_t *BindMemberChannel()
+{
+    uint8_t voice = mpe.next_voice;
+    for (uint8_t i = 0; i < NUM_VOICES; ++i) {
+        uint8_t candidate = (mpe.next_voice + i) % NUM_VOICES;
+        if (!all_voices[candidate].gate) {
+            voice = candidate;
+            break;
+        }
+    }
+    mpe.next_voice = (voice + 1) % NUM_VOICES;
+
+    key_assigner_t *key_assigner = &key_assigner_instances[voice];
+    uint8_t previous = mpe.voice_channels[voice];
+    if (previous != CHANNEL_UNBOUND) {
+        key_assigners[previous] = NULL;
+        AllNotesOff(key_assigner);
+    }
+    mpe.voice_channels[voice] = midi_channel;
+    key_assigners[midi_channel] = key_assigner;
+
+    // the controller sets up the bend and the pressure of a note before the note-on
+    VoicePitchBend(key_assigner, mpe.channel_bends[midi_channel] + BEND_CENTER);
+    ChannelPressure(key_assigner, mpe.channel_pressures[midi_channel]);
+    return key_assigner;
+}
+
+/**
+ * Drives the bend output by the master channel and the member channel of the first voice.
+ */
+static void BendFirstMpeVoice()
+{
+    int32_t semitone_amount = (int32_t)mpe.master_bend * bend_depth;
+    uint8_t channel = mpe.voice_channels[0];
+    if (channel != CHANNEL_UNBOUND) {
+        semitone_amount += (int32_t)mpe.channel_bends[channel] * mpe.member_bend_depth;
+    }
+    BendPitchBySemitones(semitone_amount);
+}
+
+static void HandleMpeMasterMessage()
+{
+    switch(midi_message) {
+    case MSG_CONTROL_CHANGE:
+        ControlChange(midi_data[0], midi_data[1]);
+        break;
+    case MSG_CHANNEL_PRESSURE:
+        RoutePressure(midi_data[0]);
+        break;
+    case MSG_PITCH_BEND:
+        mpe.master_bend = ((midi_data[1] << 7) + midi_data[0]) - BEND_CENTER;
+        BendFirstMpeVoice();
+        break;
+    default:
+        // notes on the master channel are not supported
+        break;
+    }
+}
+
+static void HandleMpeMemberMessage()
+{
+    key_assigner_t *key_assigner = key_assigners[midi_channel];
+    // the first voice drives the bend output and the pressure routes
+    uint8_t first_voice = key_assigner == &key_assigner_instances[0];
+
+    switch(midi_message) {
+    case MSG_NOTE_OFF:
+        if (key_assigner != NULL) {
+            NoteOff(key_assigner, midi_data[0]);
+        }
+        break;
+    case MSG_NOTE_ON:
+        if (key_assigner == NULL) {
+            if (midi_data[1] == 0) {
+                break;
+            }
+            key_assigner = BindMemberChannel();
+            if (key_assigner == &key_assigner_instances[0]) {
+                BendFirstMpeVoice();
+            }
+        }
+        NoteOn(key_assigner, midi_data[0], midi_data[1]);
+        break;
+    case MSG_CONTROL_CHANGE:
+        ControlChange(midi_data[0], midi_data[1]);
+        break;
+    case MSG_CHANNEL_PRESSURE:
+        mpe.channel_pressures[midi_channel] = midi_data[0];
+        if (key_assigner != NULL) {
+            if (first_voice) {
+                RoutePressure(midi_data[0]);
+            }
+            ChannelPressure(key_assigner, midi_data[0]);
+        }
+        break;
+    case MSG_POLY_KEY_PRESSURE:
+        if (key_assigner != NULL) {
+            if (first_voice && IsNoteSounding(key_assigner, &all_voices[0], midi_data[0])) {
+                RoutePressure(midi_data[1]);
+            }
+            PolyKeyPressure(key_assigner, midi_data[0], midi_data[1]);
         }
         break;
+    case MSG_PITCH_BEND: {
+        uint16_t bend = (midi_data[1] << 7) + midi_data[0];
+        mpe.channel_bends[midi_channel] = bend - BEND_CENTER;
+        if (key_assigner != NULL) {
+            VoicePitchBend(key_assigner, bend);
+            if (first_voice) {
+                BendFirstMpeVoice();
+            }
+        }
+        break;
+    }
+    default:
+        break;
     }
 }
 
+/**
+ * Watches the MPE configuration message on a master channel out of scope, so that a
+ * controller can turn a zone on. Only the parameter selection and the data entry are taken.
+ */
+static void WatchMpeConfiguration()
+{
+    if (midi_message != MSG_CONTROL_CHANGE ||
+        (midi_channel != 0 && midi_channel != NUM_MIDI_CHANNELS - 1)) {
+        return;
+    }
+    struct parameter_state *parameter = &parameters[midi_channel];
+    switch (midi_data[0]) {
+    case CC_RPN_MSB:
+        SelectParameter(parameter, PARAMETER_RPN, 1, midi_data[1]);
+        break;
+    case CC_RPN_LSB:
+        SelectParameter(parameter, PARAMETER_RPN, 0, midi_data[1]);
+        break;
+    case CC_NRPN_MSB:
+        SelectParameter(parameter, PARAMETER_NRPN, 1, midi_data[1]);
+        break;
+    case CC_NRPN_LSB:
+        SelectParameter(parameter, PARAMETER_NRPN, 0, midi_data[1]);
+        break;
+    case CC_DATA_ENTRY:
+        if (parameter->type == PARAMETER_RPN && parameter->number == RPN_MPE_CONFIGURATION) {
+            ConfigureMpeZone(midi_data[1]);
+        }
+        break;
+    }
+}
 
 void HandleMidiChannelMessage()
 {
-    // do nothing for a channel that is out of scope
+    switch (mpe_channel_roles[midi_channel]) {
+    case MPE_MASTER:
+        HandleMpeMasterMessage();
+        return;
+    case MPE_MEMBER:
+        HandleMpeMemberMessage();
+        return;
+    default:
+        break;
+    }
+
+    // do nothing for a channel that is out of scope, except for turning an MPE zone on
     key_assigner_t *key_assigner = key_assigners[midi_channel];
     if (key_assigner == NULL) {
+        WatchMpeConfiguration();
         return;
     }
 
@@ -277,9 +761,21 @@ void HandleMidiChannelMessage()
     case MSG_CONTROL_CHANGE:
         ControlChange(midi_data[0], midi_data[1]);
         break;
+    case MSG_CHANNEL_PRESSURE:
+        RoutePressure(midi_data[0]);
+        ChannelPressure(key_assigner, midi_data[0]);
+        break;
+    case MSG_POLY_KEY_PRESSURE:
+        // The shared outputs follow the first voice, so that the other held keys
+        // cannot make them jump
+        if (IsNoteSounding(key_assigner, &all_voices[0], midi_data[0])) {
+            RoutePressure(midi_data[1]);
+        }
+        PolyKeyPressure(key_assigner, midi_data[0], midi_data[1]);
+        break;
     case MSG_PITCH_BEND: {
-        int16_t bend_amount = ((midi_data[1] << 7) + midi_data[0]) - BEND_CENTER;
-        BendPitch(bend_amount);
+        last_bend_amount = ((midi_data[1] << 7) + midi_data[0]) - BEND_CENTER;
+        BendPitch(last_bend_amount);
         break;
     }
     default:
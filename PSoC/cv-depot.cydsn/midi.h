@@ -30,6 +30,20 @@
 
 #define NUM_MIDI_CHANNELS 16
 
+// MPE zones. The lower zone has the master channel on 1 and the member channels upward,
+// the upper zone on 16 and downward.
+enum MpeZone {
+    MPE_ZONE_OFF = 0,
+    MPE_ZONE_LOWER,
+    MPE_ZONE_UPPER,
+    MPE_ZONE_END,
+};
+#define MAX_MPE_MEMBER_CHANNELS 15
+
+// Bend depth of the member channels in semitones, set by RPN 0 on a member channel
+#define DEFAULT_MPE_MEMBER_BEND_DEPTH 48
+#define MAX_MPE_MEMBER_BEND_DEPTH 96
+
 /**
  * Global MIDI configuration
  */
@@ -38,6 +52,8 @@ typedef struct midi_config {
     uint8_t channels[NUM_VOICES];  // MIDI channels for notes
     enum KeyPriority key_priority;
     uint8_t expression_or_breath; // 0: expression, 1: breath
+    uint8_t mpe_zone;             // enum MpeZone, overrides the channels if on
+    uint8_t mpe_member_channels;  // set by the MPE configuration message, not saved
 } midi_config_t;
 
 // The master MIDI config
@@ -46,6 +62,12 @@ extern midi_config_t midi_config;
 extern void InitializeMidiControllers();
 extern void InitializeMidiDecoder();
 
+/**
+ * Maps the MIDI channels to the key assigners by the channels or the MPE zone in the
+ * midi_config. Leaves the decoder state as is.
+ */
+extern void AssignMidiChannels();
+
 /**
  * Accesses to the master MIDI config are done through these methods.
  */
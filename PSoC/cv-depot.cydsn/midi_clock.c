@@ -0,0 +1,139 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2025 Naoki Iwakami
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "project.h"
+
+#include "analog3.h"
+#include "clock_gate.h"
+#include "lfo.h"
+#include "main.h"
+#include "midi_clock.h"
+
+/* MIDI System Real-Time Messages */
+#define MSG_TIMING_CLOCK 0xF8
+#define MSG_START        0xFA
+#define MSG_CONTINUE     0xFB
+#define MSG_STOP         0xFC
+
+// Clocks further apart than 125ms (20 BPM) are taken as a restart
+#define CLOCK_TIMEOUT_TICKS 5854
+
+// Loop filter gains as shifts: the phase and the period follow 1/4 and 1/32 of the error
+#define PHASE_GAIN_SHIFT 2
+#define PERIOD_GAIN_SHIFT 5
+
+// 60s x 100 / (24 clocks x 21.354us) in Q8, divided by the period gives 1/100 BPM
+#define TEMPO_FACTOR 2997096550u
+
+midi_clock_t midi_clock;
+
+void InitializeMidiClock()
+{
+    midi_clock.running = 0;
+    midi_clock.locked = 0;
+    midi_clock.num_clocks = 0;
+    midi_clock.count = 0;
+    midi_clock.period = 0;
+}
+
+static void TrackClock(uint32_t now)
+{
+    uint32_t interval = now - midi_clock.last_time;
+    midi_clock.last_time = now;
+    if (midi_clock.num_clocks > 0 && interval > CLOCK_TIMEOUT_TICKS) {
+        // the clock has stopped for a while, start over
+        midi_clock.num_clocks = 0;
+        midi_clock.locked = 0;
+    }
+    if (midi_clock.num_clocks < 2) {
+        if (++midi_clock.num_clocks == 2) {
+            midi_clock.period = interval << 8;
+            midi_clock.predicted = (now << 8) + midi_clock.period;
+            midi_clock.locked = 1;
+        }
+        return;
+    }
+
+    int32_t error = (int32_t)((now << 8) - midi_clock.predicted);
+    uint32_t magnitude = error >= 0 ? error : -error;
+    if (magnitude > midi_clock.period / 2) {
+        // tempo jump or lost clocks, acquire again
+        midi_clock.period = interval << 8;
+        midi_clock.predicted = (now << 8) + midi_clock.period;
+        return;
+    }
+    // second order loop: correct the phase and the period by the error
+    midi_clock.period += error >> PERIOD_GAIN_SHIFT;
+    midi_clock.predicted += (error >> PHASE_GAIN_SHIFT) + midi_clock.period;
+}
+
+void HandleMidiRealTime(uint8_t rx_byte)
+{
+    uint32_t now = timer_counter;
+    CAN_DATA_BYTES_MSG data;
+    switch (rx_byte) {
+    case MSG_TIMING_CLOCK:
+        // forward first to keep the latency low
+        A3SendDataStandard(A3_ID_MIDI_TIMING_CLOCK, 0, &data);
+        TrackClock(now);
+        if (midi_clock.running) {
+            ClockGateHandleClock(midi_clock.count, now);
+            LfoHandleClock(midi_clock.count);
+            ++midi_clock.count;
+        }
+        break;
+    case MSG_START:
+        midi_clock.count = 0;
+        midi_clock.running = 1;
+        ClockGateHandleStart(now);
+        data.byte[0] = rx_byte;
+        A3SendDataStandard(A3_ID_MIDI_REAL_TIME, 1, &data);
+        break;
+    case MSG_CONTINUE:
+        midi_clock.running = 1;
+        data.byte[0] = rx_byte;
+        A3SendDataStandard(A3_ID_MIDI_REAL_TIME, 1, &data);
+        break;
+    case MSG_STOP:
+        midi_clock.running = 0;
+        ClockGateHandleStop();
+        data.byte[0] = rx_byte;
+        A3SendDataStandard(A3_ID_MIDI_REAL_TIME, 1, &data);
+        break;
+    default:
+        // active sensing and reset are not supported
+        break;
+    }
+}
+
+uint16_t GetMidiClockTempo()
+{
+    if (!midi_clock.locked || midi_clock.period == 0) {
+        return 0;
+    }
+    uint32_t tempo = TEMPO_FACTOR / midi_clock.period;
+    return tempo > 0xffff ? 0xffff : tempo;
+}
+
+/* [] END OF FILE */
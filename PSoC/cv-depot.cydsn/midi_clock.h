@@ -0,0 +1,64 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2025 Naoki Iwakami
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * MIDI clock tracking.
+ *
+ * Timing clocks are timestamped by the timer counter and tracked by a PLL-style filter
+ * that estimates the clock period, so that the tempo is known between the clocks.
+ * Clocks and transport messages are forwarded to Analog3.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#define MIDI_CLOCKS_PER_BEAT 24
+
+typedef struct midi_clock {
+    uint8_t running;     // between start or continue and stop
+    uint8_t locked;      // the period estimate follows the clocks
+    uint8_t num_clocks;  // clocks since the estimate was reset, up to 2
+    uint32_t count;      // clocks since the start
+    uint32_t last_time;  // timer_counter at the latest clock
+    uint32_t period;     // estimated clock period in timer ticks, Q24.8
+    uint32_t predicted;  // predicted time of the next clock in timer ticks, Q24.8, wraps around
+} midi_clock_t;
+
+extern midi_clock_t midi_clock;
+
+extern void InitializeMidiClock();
+
+/**
+ * Handles a system real-time message. Called by the MIDI decoder as soon as the byte
+ * arrives, regardless of the other messages in progress.
+ */
+extern void HandleMidiRealTime(uint8_t rx_byte);
+
+/**
+ * Returns the tempo estimated from the MIDI clock in 1/100 BPM, 0 if unknown.
+ */
+extern uint16_t GetMidiClockTempo();
+
+/* [] END OF FILE */
@@ -31,6 +31,18 @@ pot_t pot_note_2;
 pot_t pot_portament_1;
 pot_t pot_portament_2;
 
+static pot_t *const all_pots[NUM_POTS] = {
+    &pot_note_1,
+    &pot_note_2,
+    &pot_portament_1,
+    &pot_portament_2,
+};
+
+// State of the group command. Pots in the group share the phase.
+static uint8_t group_phase = PHASE_IDLE;
+static uint8_t group_direction;  // 1: up, 0: down
+static uint8_t last_direction;
+
 void PotGlobalInit()
 {
     Pin_Pot_UD_Write(0);
@@ -38,6 +50,8 @@ void PotGlobalInit()
     PotInit(&pot_note_2, POT_NOTE_2);
     PotInit(&pot_portament_1, POT_PORTAMENT_1);
     PotInit(&pot_portament_2, POT_PORTAMENT_2);
+    group_phase = PHASE_IDLE;
+    last_direction = 0;
 }
 
 static void SelectDevice(enum PotId pot_id, uint8_t value)
@@ -89,33 +103,126 @@ void PotEnsureToMoveToB(pot_t *pot)
     pot->target = 0;
 }
 
-uint8_t PotUpdate(pot_t *pot)
+uint8_t PotIsIdle(const pot_t *pot)
+{
+    return pot->phase == PHASE_IDLE && pot->current == pot->target;
+}
+
+static uint8_t WantsToMove(const pot_t *pot, uint8_t direction)
 {
-    if (pot->current == pot->target) {
-        SelectDevice(pot->pot_id, 1);
-        pot->phase = PHASE_IDLE;
-        return 1;
+    return pot->current != pot->target && (pot->target > pot->current) == direction;
+}
+
+/**
+ * Selects idle pots that move in the group direction. The U/D port must be at the
+ * direction level so that the devices latch the right mode.
+ *
+ * @returns uint8_t: 1 if any pot has joined
+ */
+static uint8_t JoinGroup()
+{
+    uint8_t joined = 0;
+    for (uint8_t i = 0; i < NUM_POTS; ++i) {
+        pot_t *pot = all_pots[i];
+        if (pot->phase == PHASE_IDLE && WantsToMove(pot, group_direction)) {
+            SelectDevice(pot->pot_id, 0);
+            pot->phase = PHASE_STEPPING;
+            joined = 1;
+        }
+    }
+    return joined;
+}
+
+/**
+ * Deselects pots that have reached the targets or have to turn around.
+ *
+ * @returns uint8_t: number of pots remaining in the group
+ */
+static uint8_t LeaveGroup()
+{
+    uint8_t remaining = 0;
+    for (uint8_t i = 0; i < NUM_POTS; ++i) {
+        pot_t *pot = all_pots[i];
+        if (pot->phase == PHASE_IDLE) {
+            continue;
+        }
+        if (WantsToMove(pot, group_direction)) {
+            ++remaining;
+        } else {
+            SelectDevice(pot->pot_id, 1);
+            pot->phase = PHASE_IDLE;
+        }
     }
-    switch (pot->phase) {
-    case PHASE_IDLE:
-        pot->level = pot->target > pot->current ? 1 : 0;
-        Pin_Pot_UD_Write(pot->level);
-        pot->phase = PHASE_DIRECTION_SET;
+    return remaining;
+}
+
+/**
+ * Picks the direction of the next group command.
+ *
+ * @returns int8_t: 1 for up, 0 for down, -1 if no pot has to move
+ */
+static int8_t ChooseDirection()
+{
+    uint8_t up = 0;
+    uint8_t down = 0;
+    for (uint8_t i = 0; i < NUM_POTS; ++i) {
+        up |= WantsToMove(all_pots[i], 1);
+        down |= WantsToMove(all_pots[i], 0);
+    }
+    if (up && down) {
+        // take turns
+        return !last_direction;
+    }
+    return up ? 1 : down ? 0 : -1;
+}
+
+/**
+ * Makes a step of all pots in the group. The device counts the wiper up or down
+ * on the rising edge of the U/D port in either mode, so the pulse shape depends
+ * on the direction level.
+ */
+static void Step()
+{
+    Pin_Pot_UD_Write(!group_direction);
+    CyDelayUs(POT_PULSE_WIDTH_US);
+    Pin_Pot_UD_Write(group_direction);
+    for (uint8_t i = 0; i < NUM_POTS; ++i) {
+        pot_t *pot = all_pots[i];
+        if (pot->phase != PHASE_IDLE) {
+            pot->current += group_direction ? 1 : -1;
+        }
+    }
+}
+
+uint8_t PotUpdateAll()
+{
+    switch (group_phase) {
+    case PHASE_IDLE: {
+        int8_t direction = ChooseDirection();
+        if (direction < 0) {
+            return 1;
+        }
+        group_direction = direction;
+        last_direction = direction;
+        Pin_Pot_UD_Write(group_direction);
+        group_phase = PHASE_DIRECTION_SET;
         return 0;
+    }
     case PHASE_DIRECTION_SET:
-        SelectDevice(pot->pot_id, 0);
-        pot->phase = PHASE_TO_LOAD;
-        return 0;
-    case PHASE_TO_LOAD:
-        pot->level ^= 1;
-        Pin_Pot_UD_Write(pot->level);
-        pot->phase = PHASE_TO_TRIGGER;
+        JoinGroup();
+        group_phase = PHASE_STEPPING;
         return 0;
-    case PHASE_TO_TRIGGER:
-        pot->level ^= 1;
-        Pin_Pot_UD_Write(pot->level);
-        pot->current += pot->target > pot->current ? 1 : -1;
-        pot->phase = PHASE_TO_LOAD;
+    case PHASE_STEPPING:
+        // Between pulses. The U/D port is at the direction level here.
+        if (LeaveGroup() == 0) {
+            group_phase = PHASE_IDLE;
+            return ChooseDirection() < 0;
+        }
+        if (JoinGroup()) {
+            // give the new members a cycle before the first pulse
+            return 0;
+        }
+        Step();
         return 0;
     }
     return 1;
@@ -35,12 +35,17 @@
  *   Pin_Pot_Select_* - to enable U/D command for eatch device
  *   Pin_Pot_UD - shared U/D command port
  *
- * The behavior of the pot control is asynchronous. Once a command starts, the main program must call
- * PotUpdate() method periodically until a command completes. There's no timing control in this library.
- * The main program has responsibility to throttle method calls. See the data sheet for the precise
- * timing requirements. Though required minimum time interval is pretty short typically (less than 1uS),
- * it's unlikely that the main program has to run any timing control if we put the method call in the
- * main loop.
+ * Since the U/D port is shared, pots that move in the same direction are driven together.
+ * The driver selects all of them and clocks the U/D port once per step for the whole group.
+ * A pot leaves the group as soon as it reaches its target. Pots moving in the other direction
+ * wait until the group completes. The driver alternates the direction when both are waiting.
+ *
+ * The behavior of the pot control is asynchronous. Once a command starts, PotUpdateAll() must be
+ * called periodically until the command completes. The method is called by the PWM_Bend cycle
+ * interrupt (about 21.354us, see main.c), so the wiper moves one step per cycle regardless of the
+ * main loop load. The main program only sets targets through pot_change.h. Each step is a single
+ * U/D pulse of POT_PULSE_WIDTH_US, which is well above the minimum U/D high and low times in the
+ * data sheet (500ns). The cycle interval also covers the CS and U/D setup times between phases.
  */
 
 #pragma once
@@ -53,20 +58,22 @@ enum PotId {
     POT_PORTAMENT_1,
     POT_PORTAMENT_2,
 };
+#define NUM_POTS 4
 
 // pot control phases
 enum PotCommandPhase {
     PHASE_IDLE,
     PHASE_DIRECTION_SET,
-    PHASE_TO_LOAD,
-    PHASE_TO_TRIGGER,
+    PHASE_STEPPING,
 };
 
+// U/D pulse width for a step
+#define POT_PULSE_WIDTH_US 1
+
 typedef struct pot {
     uint8_t current;
     uint8_t target;
-    uint8_t phase;
-    uint8_t level;
+    uint8_t phase;  // PHASE_IDLE when the device is not selected
     enum PotId pot_id;
 } pot_t;
 
@@ -108,21 +115,33 @@ extern void PotSetTargetPosition(pot_t *pot, int8_t target);
  * Request to move the wiper position to the terminal B.
  *
  * It is done by moving the wiper downwards 63 times.
+ * The pot must not be selected by a command in progress.
  */
 extern void PotEnsureToMoveToB(pot_t *pot);
 
 /**
- * Updates the corresponding pot based on the pot object.
- *
- * If the target position is different from current position,
- * the method starts writing to the corresponding pot to move the
- * wiper. The method proceeds only one pot command step per call.
- * The main program should call this method periodically until the
- * command completes.
+ * Checks if the pot is out of any command.
  *
  * @param pot: pot_t - The pot object
- * @returns uint8_t: 0 if the command is in progress, 1 otherwise
+ * @returns uint8_t: 1 if the wiper is at the target and the device is not selected, 0 otherwise
+ */
+extern uint8_t PotIsIdle(const pot_t *pot);
+
+/**
+ * Updates all pots based on the pot objects.
+ *
+ * If any target position is different from current position,
+ * the method starts writing to the corresponding pots to move the
+ * wipers. The method proceeds only one command phase per call.
+ * The timer interrupt calls this method periodically until the
+ * command completes. A step of the wipers is made in a single call.
+ *
+ * The targets may be changed while a command is in progress. A pot whose
+ * new target is on the other side of the wiper leaves the group and joins
+ * a later command in the new direction.
+ *
+ * @returns uint8_t: 0 if a command is in progress, 1 otherwise
  */
-extern uint8_t PotUpdate(pot_t *pot);
+extern uint8_t PotUpdateAll();
 
 /* [] END OF FILE */
@@ -22,63 +22,170 @@
  * SOFTWARE.
  */
 
+#include <stddef.h>
+
+#include "project.h"
+
 #include "pot.h"
 #include "pot_change.h"
 
-typedef struct pot_change_request {
-    uint8_t requested;
-    int8_t target;  // set -1 to ensure to move to the terminal B
+enum Homing {
+    HOMING_NONE,
+    HOMING_REQUESTED,
+    HOMING_IN_PROGRESS,
+};
+
+/*
+ * Each pot has a slot that keeps the latest request. A newer target simply overwrites
+ * an older one, so the wiper never walks through stale intermediate positions.
+ */
+typedef struct pot_change_slot {
     pot_t *pot;
-} pot_change_request_t;
+    int8_t target;      // latest requested wiper position
+    uint8_t requested;  // the target is waiting to be applied
+    uint8_t homing;     // enum Homing
+} pot_change_slot_t;
 
-// Request queue
-#define REQUEST_QUEUE_SIZE 8
-static pot_change_request_t pot_change_requests[REQUEST_QUEUE_SIZE];
-static uint8_t request_head = 0;
-static uint8_t request_tail = 0;
-static uint8_t pot_queue_overflow = 0;
+/*
+ * The slots are written by the main program and consumed by the timer interrupt.
+ */
+static volatile pot_change_slot_t slots[NUM_POTS];
+static volatile uint8_t pending_slots;  // bit mask of slots with requests to apply
+static uint8_t driver_busy;
 
+/*
+ * Last wiper positions of the devices.
+ *
+ * The MCP4011 is volatile and its wiper returns to 1Fh when the power goes off. The positions
+ * are meaningful only as long as the devices are powered, and so is the SRAM of this chip.
+ * The record is kept in the SRAM that is not cleared by the startup code, so it survives resets
+ * that keep the power on (software, watchdog, XRES) with no EEPROM wear.
+ */
+#define POT_STATE_MAGIC 0x504f5401  // "POT" + version
+typedef struct pot_state {
+    uint32_t magic;
+    uint8_t valid;  // cleared while the wipers are moving
+    uint8_t wipers[NUM_POTS];
+    uint8_t checksum;
+} pot_state_t;
+
+static pot_state_t pot_state __attribute__((section(".noinit")));
+
+// Resets caused by supply voltage drops. The devices may or may not have reset in this case.
+#define BROWN_OUT_RESETS (CY_RESET_LVID | CY_RESET_LVIA | CY_RESET_HVIA)
+
+static uint8_t PotStateChecksum()
+{
+    uint8_t sum = pot_state.valid;
+    for (uint8_t i = 0; i < NUM_POTS; ++i) {
+        sum += pot_state.wipers[i];
+    }
+    return ~sum;
+}
+
+static void SavePotState(uint8_t valid)
+{
+    pot_state.valid = valid;
+    if (valid) {
+        for (uint8_t i = 0; i < NUM_POTS; ++i) {
+            pot_state.wipers[i] = slots[i].pot != NULL ? slots[i].pot->current : 0x1f;
+        }
+    }
+    pot_state.checksum = PotStateChecksum();
+}
 
 uint8_t PotChangePlaceRequest(pot_t *pot, int8_t wiper_position)
 {
-    if (pot_queue_overflow) {
+    // This may be called before the interrupts are enabled at boot
+    uint8_t interrupt_state = CyEnterCriticalSection();
+    volatile pot_change_slot_t *slot = &slots[pot->pot_id];
+    slot->pot = pot;
+    if (wiper_position < 0) {
+        // the wiper ends up at the terminal B, older target is meaningless
+        slot->homing = HOMING_REQUESTED;
+        slot->requested = 0;
+    } else {
+        slot->target = wiper_position;
+        slot->requested = 1;
+    }
+    pending_slots |= 1 << pot->pot_id;
+    CyExitCriticalSection(interrupt_state);
+    return 0;
+}
+
+uint8_t PotChangeRestorePositions(pot_t *const pots[NUM_POTS])
+{
+    if (CyResetStatus & BROWN_OUT_RESETS) {
+        pot_state.magic = 0;
+        return 0;
+    }
+    if (pot_state.magic != POT_STATE_MAGIC) {
+        // The SRAM is fresh, so is the power of the devices. They are at the power-on default.
+        for (uint8_t i = 0; i < NUM_POTS; ++i) {
+            slots[i].pot = pots[i];
+            pots[i]->current = pots[i]->target = 0x1f;
+        }
+        pot_state.magic = POT_STATE_MAGIC;
+        SavePotState(1);
         return 1;
     }
-    pot_change_request_t *request_item = &pot_change_requests[request_tail];
-    request_tail = (request_tail + 1) % REQUEST_QUEUE_SIZE;
-    if (request_head == request_tail) {
-        pot_queue_overflow = 1;
+    if (!pot_state.valid || pot_state.checksum != PotStateChecksum()) {
+        // reset while moving, or broken record
+        return 0;
     }
+    for (uint8_t i = 0; i < NUM_POTS; ++i) {
+        slots[i].pot = pots[i];
+        pots[i]->current = pots[i]->target = pot_state.wipers[i] & 0x3f;
+    }
+    return 1;
+}
 
-    request_item->requested = 0;
-    request_item->pot = pot;
-    request_item->target = wiper_position;
-
-    return 0;
+uint8_t PotChangeIsSettled(const pot_t *pot)
+{
+    return !(pending_slots & (1 << pot->pot_id)) && PotIsIdle(pot);
 }
 
 void PotChangeHandleRequests()
 {
-    if (request_head == request_tail && !pot_queue_overflow) {
+    if (pending_slots == 0 && !driver_busy) {
         // nothing to handle
         return;
     }
-
-    pot_change_request_t *item = &pot_change_requests[request_head];
-    pot_t *pot = item->pot;
-
-    if (!item->requested) {
-        if (item->target < 0) {
-            PotEnsureToMoveToB(pot);
-        } else {
-            PotSetTargetPosition(pot, item->target);
+    for (uint8_t i = 0; i < NUM_POTS; ++i) {
+        if (!(pending_slots & (1 << i))) {
+            continue;
+        }
+        volatile pot_change_slot_t *slot = &slots[i];
+        pot_t *pot = slot->pot;
+        switch (slot->homing) {
+        case HOMING_REQUESTED:
+            if (pot->phase == PHASE_IDLE) {
+                PotEnsureToMoveToB(pot);
+                slot->homing = HOMING_IN_PROGRESS;
+            } else {
+                // let the pot leave the current command first
+                PotSetTargetPosition(pot, pot->current);
+            }
+            continue;
+        case HOMING_IN_PROGRESS:
+            if (!PotIsIdle(pot)) {
+                continue;
+            }
+            slot->homing = HOMING_NONE;
+            break;
+        }
+        if (slot->requested) {
+            PotSetTargetPosition(pot, slot->target);
+            slot->requested = 0;
         }
-        item->requested = 1;
+        pending_slots &= ~(1 << i);
     }
 
-    if (PotUpdate(pot)) {
-        request_head = (request_head + 1) % REQUEST_QUEUE_SIZE;
-        pot_queue_overflow = 0;
+    uint8_t busy = !PotUpdateAll();
+    if (busy != driver_busy) {
+        // positions are uncertain while moving
+        SavePotState(!busy);
+        driver_busy = busy;
     }
 }
 
@@ -29,6 +29,10 @@
 /**
  * Schedule a pot wiper change request.
  *
+ * Each pot keeps only its latest request. A new target supersedes the one that is
+ * pending or being sought. A move to the terminal B is always completed before
+ * the pot seeks a target requested after it.
+ *
  * @param pot: pot_t - Pot to modify
  * @param wiper_position: int8_t - Wiper position. Set 0 to 63 to seek the position.
  *   Set -1 if current wiper position is lost and ensure to return to the terminal B.
@@ -36,6 +40,35 @@
  */
 extern uint8_t PotChangePlaceRequest(pot_t *pot, int8_t wiper_position);
 
+/**
+ * Restores the wiper positions of the pots at boot.
+ *
+ * The positions are known after a power-on (the device default) or a reset that kept
+ * the devices powered while they were not moving. They are unknown after a brown-out,
+ * a reset during a move, or when the saved record is broken. The caller should request
+ * to move the pots to the terminal B in that case.
+ *
+ * @param pots: pot_t *[] - All pots in the order of enum PotId
+ * @returns 1 if the wiper positions are known, 0 otherwise
+ */
+extern uint8_t PotChangeRestorePositions(pot_t *const pots[NUM_POTS]);
+
+/**
+ * Checks if all requests to the pot are done.
+ *
+ * @param pot: pot_t - Pot to check
+ * @returns 1 if the wiper is at the latest requested position, 0 otherwise
+ */
+extern uint8_t PotChangeIsSettled(const pot_t *pot);
+
+/**
+ * Drives the pots toward the requested positions by one command phase.
+ *
+ * Pots that move in the same direction are stepped together. See pot.h for how the
+ * groups take turns on the shared U/D line.
+ *
+ * The method is called by the timer interrupt handler. The main program should not call it.
+ */
 extern void PotChangeHandleRequests();
 
 /* [] END OF FILE */
@@ -26,6 +26,7 @@
 
 #include "project.h"
 
+#include "clock_gate.h"
 #include "hardware.h"
 #include "main.h"
 #include "midi.h"
@@ -46,6 +47,9 @@ static void InitiateMidiChannelSetup2();
 static void InitiateGateTypeSetup();
 static void InitiateBendDepthSetup();
 static void InitiateExpressionSetup();
+static void InitiatePortamentSetup();
+static void InitiateGateOutputSetup1();
+static void InitiateGateOutputSetup2();
 
 // Menu items would change by the configuration. The menu is built on demand by the switch interrupt
 // handler. It should be done quickly, so the menu items are kept in the static space.
@@ -56,16 +60,21 @@ static const menu_t kMenuSetKeyAssignment = { "asn", InitiateKeyAssignSetup };
 static const menu_t kMenuSetGateType = { "gat", InitiateGateTypeSetup };
 static const menu_t kMenuSetBendDepth = { "bnd", InitiateBendDepthSetup };
 static const menu_t kMenuSetExpressionOrBreath = { "exp", InitiateExpressionSetup };
+static const menu_t kMenuSetPortament = { "prt", InitiatePortamentSetup };
+static const menu_t kMenuSetGateOutput1 = { "cl1", InitiateGateOutputSetup1 }; // clock out of gate 1
+static const menu_t kMenuSetGateOutput2 = { "cl2", InitiateGateOutputSetup2 }; // clock out of gate 2
 static const menu_t kMenuCalibrate = { "cal", Calibrate }; // calibrate the octave range
 static const menu_t kMenuDiagnose = { "dgn", Diagnose }; // diagnose the hardware
 
 const char *kKeyAssignmentModeName[KEY_ASSIGN_END] = { "duo", "uni", "par" };
 const char *kGateTypeName[GATE_TYPE_END] = { "a3 ", "leg" };
 const char *kExpressionInputName[GATE_TYPE_END] = { "exp ", "brt" };
+const char *kPortamentModeName[PORTAMENT_MODE_END] = { "off", "all", "leg", "fng" };
+const char *kGateOutputName[GATE_OUTPUT_END] = { "not", "24 ", "4  ", "8  ", "16 ", "8t ", "16t", "rst" };
 
 // Setup operation states ///////////////////////
 
-#define MAX_MENU_SIZE 9
+#define MAX_MENU_SIZE 11
 
 struct menu_selection {
     const menu_t *menu[MAX_MENU_SIZE];
@@ -73,6 +82,11 @@ struct menu_selection {
     uint8_t menu_item;
 };
 
+struct gate_output_setup {
+    enum Voice selected_voice;
+    enum GateOutput gate_output;
+};
+
 struct midi_setup {
     enum Voice selected_voice;
     midi_config_t config;
@@ -87,6 +101,8 @@ struct setup_state {
         struct midi_setup midi;
         enum GateType gate_type;
         uint8_t bend_depth;
+        enum PortamentMode portament_mode;
+        struct gate_output_setup gate_output;
     } mode;
 };
 
@@ -105,6 +121,9 @@ static void BuildMenu()
     setup_state.mode.menu.menu[i++] = &kMenuSetGateType;
     setup_state.mode.menu.menu[i++] = &kMenuSetBendDepth;
     setup_state.mode.menu.menu[i++] = &kMenuSetExpressionOrBreath;
+    setup_state.mode.menu.menu[i++] = &kMenuSetPortament;
+    setup_state.mode.menu.menu[i++] = &kMenuSetGateOutput1;
+    setup_state.mode.menu.menu[i++] = &kMenuSetGateOutput2;
     setup_state.mode.menu.menu[i++] = &kMenuCalibrate;
     setup_state.mode.menu.menu[i++] = &kMenuDiagnose;
     setup_state.mode.menu.menu_size = i;
@@ -184,6 +203,37 @@ void InitiateExpressionSetup()
     setup_state.mode.midi.blink_count = 0;
 }
 
+void InitiatePortamentSetup()
+{
+    mode = MODE_PORTAMENT_SETUP;
+    GREEN_ENCODER_LED_ON();
+    RED_ENCODER_LED_ON();
+    setup_state.mode.portament_mode = portament_mode;
+    QuadDec_SetCounter(portament_mode);
+    setup_state.prev_counter_value = -1;
+}
+
+static void InitiateGateOutputSetup(enum Voice selected_voice)
+{
+    mode = MODE_GATE_OUTPUT_SETUP;
+    GREEN_ENCODER_LED_ON();
+    RED_ENCODER_LED_ON();
+    setup_state.mode.gate_output.selected_voice = selected_voice;
+    setup_state.mode.gate_output.gate_output = gate_outputs[selected_voice];
+    QuadDec_SetCounter(gate_outputs[selected_voice]);
+    setup_state.prev_counter_value = -1;
+}
+
+void InitiateGateOutputSetup1()
+{
+    InitiateGateOutputSetup(VOICE_1);
+}
+
+void InitiateGateOutputSetup2()
+{
+    InitiateGateOutputSetup(VOICE_2);
+}
+
 // Settings event handlers ///////////////////////////////////////////////////
 
 static void InvokeMenu()
@@ -337,6 +387,45 @@ static void ConfirmExpression()
     mode = MODE_NORMAL;
 }
 
+static void HandlePortamentSetup()
+{
+    int8_t value = PickUpChangedEncoderValue(PORTAMENT_MODE_END);
+    if (value >= 0) {
+        LED_Driver_WriteString7Seg(kPortamentModeName[value], 0);
+        setup_state.mode.portament_mode = value;
+    }
+}
+
+static void ConfirmPortament()
+{
+    GREEN_ENCODER_LED_OFF();
+    RED_ENCODER_LED_OFF();
+    UpdatePortamentMode(setup_state.mode.portament_mode, 1);
+    StartFinalization();
+    mode = MODE_NORMAL;
+}
+
+static void HandleGateOutputSetup()
+{
+    int8_t value = PickUpChangedEncoderValue(GATE_OUTPUT_END);
+    if (value >= 0) {
+        LED_Driver_WriteString7Seg(kGateOutputName[value], 0);
+        setup_state.mode.gate_output.gate_output = value;
+    }
+}
+
+static void ConfirmGateOutput()
+{
+    GREEN_ENCODER_LED_OFF();
+    RED_ENCODER_LED_OFF();
+    struct gate_output_setup *setup = &setup_state.mode.gate_output;
+    if (UpdateGateOutput(setup->selected_voice, setup->gate_output, 1)) {
+        KeyAssigner_ConnectVoices();
+    }
+    StartFinalization();
+    mode = MODE_NORMAL;
+}
+
 // Entry points ///////////////////////////////////////////////////////////////////////////////
 
 /**
@@ -385,6 +474,18 @@ void HandleSettingModes()
     case MODE_EXPRESSION_CONFIRMED:
         ConfirmExpression();
         break;
+    case MODE_PORTAMENT_SETUP:
+        HandlePortamentSetup();
+        break;
+    case MODE_PORTAMENT_CONFIRMED:
+        ConfirmPortament();
+        break;
+    case MODE_GATE_OUTPUT_SETUP:
+        HandleGateOutputSetup();
+        break;
+    case MODE_GATE_OUTPUT_CONFIRMED:
+        ConfirmGateOutput();
+        break;
     }
 }
 
@@ -417,6 +518,12 @@ void HandleSwitchEvent()
     case MODE_EXPRESSION_SETUP:
         mode = MODE_EXPRESSION_CONFIRMED;
         break;
+    case MODE_PORTAMENT_SETUP:
+        mode = MODE_PORTAMENT_CONFIRMED;
+        break;
+    case MODE_GATE_OUTPUT_SETUP:
+        mode = MODE_GATE_OUTPUT_CONFIRMED;
+        break;
     case MODE_CALIBRATION_INIT:
         mode = MODE_CALIBRATION_BEND_WIDTH;
         break;
@@ -0,0 +1,171 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2025 Naoki Iwakami
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "project.h"
+
+#include "analog3.h"
+#include "config.h"
+#include "eeprom.h"
+#include "sysex.h"
+
+// Calibration data from ADDR_BEND_OFFSET to ADDR_NOTE_2_WIPER
+#define CALIBRATION_SIZE (ADDR_NOTE_2_WIPER + 1 - ADDR_BEND_OFFSET)
+
+enum RxState {
+    RX_IGNORE = 0,  // not for us, or broken
+    RX_MANUFACTURER,
+    RX_DEVICE,
+    RX_COMMAND,
+    RX_RECORD_ID,
+    RX_RECORD_SIZE,
+    RX_DATA_HIGH,
+    RX_DATA_LOW,
+};
+
+// The receiver keeps only the record in progress
+static struct sysex_rx {
+    uint8_t state;
+    uint8_t id;
+    uint8_t size;
+    uint8_t position;
+    uint8_t high;
+    uint8_t data[A3_MAX_CONFIG_DATA_LENGTH];
+} rx;
+
+static uint8_t IntegerSize(uint8_t value_type)
+{
+    switch (value_type) {
+    case A3_U8:
+        return 1;
+    case A3_U16:
+        return 2;
+    case A3_U32:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+static void CommitRecord()
+{
+    if (rx.id == SYSEX_RECORD_CALIBRATION) {
+        for (uint8_t i = 0; i < rx.size && i < CALIBRATION_SIZE; ++i) {
+            WriteBackEepromByte(rx.data[i], ADDR_BEND_OFFSET + i);
+        }
+        return;
+    }
+    if (rx.id >= NUM_PROPS) {
+        // unknown property
+        return;
+    }
+    a3_property_t *prop = &config[rx.id];
+    if (prop->protected || prop->commit == NULL) {
+        return;
+    }
+    uint8_t integer_size = IntegerSize(prop->value_type);
+    if (integer_size) {
+        if (rx.size != integer_size) {
+            return;
+        }
+        // big endian to native
+        uint8_t value[4];
+        for (uint8_t i = 0; i < integer_size; ++i) {
+            value[i] = rx.data[integer_size - i - 1];
+        }
+        memcpy(rx.data, value, integer_size);
+    }
+
+    // Apply now, save later
+    CommitPropertyUnsaved(prop, rx.data, rx.size);
+    WriteBackProperty(prop);
+}
+
+void SysExStart()
+{
+    rx.state = RX_MANUFACTURER;
+}
+
+void SysExConsume(uint8_t rx_byte)
+{
+    switch (rx.state) {
+    case RX_MANUFACTURER:
+        rx.state = rx_byte == SYSEX_MANUFACTURER_ID ? RX_DEVICE : RX_IGNORE;
+        break;
+    case RX_DEVICE:
+        rx.state = rx_byte == SYSEX_DEVICE_ID ? RX_COMMAND : RX_IGNORE;
+        break;
+    case RX_COMMAND:
+        rx.state = rx_byte == SYSEX_COMMAND_DATA ? RX_RECORD_ID : RX_IGNORE;
+        break;
+    case RX_RECORD_ID:
+        rx.id = rx_byte;
+        rx.state = RX_RECORD_SIZE;
+        break;
+    case RX_RECORD_SIZE:
+        if (rx_byte > A3_MAX_CONFIG_DATA_LENGTH) {
+            rx.state = RX_IGNORE;
+            break;
+        }
+        rx.size = rx_byte;
+        rx.position = 0;
+        if (rx.size == 0) {
+            CommitRecord();
+            rx.state = RX_RECORD_ID;
+        } else {
+            rx.state = RX_DATA_HIGH;
+        }
+        break;
+    case RX_DATA_HIGH:
+        if (rx_byte > 0x0f) {
+            // not a nibble, the record and the rest are broken
+            rx.state = RX_IGNORE;
+            break;
+        }
+        rx.high = rx_byte << 4;
+        rx.state = RX_DATA_LOW;
+        break;
+    case RX_DATA_LOW:
+        if (rx_byte > 0x0f) {
+            rx.state = RX_IGNORE;
+            break;
+        }
+        rx.data[rx.position++] = rx.high | rx_byte;
+        if (rx.position == rx.size) {
+            CommitRecord();
+            rx.state = RX_RECORD_ID;
+        } else {
+            rx.state = RX_DATA_HIGH;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void SysExEnd()
+{
+    rx.state = RX_IGNORE;
+}
+
+/* [] END OF FILE */
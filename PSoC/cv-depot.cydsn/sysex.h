@@ -0,0 +1,65 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2025 Naoki Iwakami
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * System exclusive messages for bulk configuration.
+ *
+ * The config properties and the calibration data are loaded by a message of records:
+ *
+ *   F0 7D 01 02 <record>... F7
+ *   record: <property ID> <size> <data bytes, each in two nibbles, high first>
+ *
+ * where the data bytes are laid out as in the Analog3 config stream, and the calibration
+ * is a record of SYSEX_RECORD_CALIBRATION. The module has no MIDI output, so it cannot
+ * dump the values by itself; command 01 is reserved for a dump request.
+ *
+ * The message is parsed as the bytes arrive. Each property is applied as soon as its
+ * record completes, and saved by the EEPROM write-back in the background.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#define SYSEX_MANUFACTURER_ID 0x7d  // non-commercial
+#define SYSEX_DEVICE_ID 0x01        // the module type
+
+#define SYSEX_COMMAND_DATA 0x02
+
+// Raw EEPROM bytes of the bend and the note calibration, effective from the next start
+#define SYSEX_RECORD_CALIBRATION 0x7f
+
+/**
+ * Handles the bytes of a system exclusive message, from the first data byte after F0.
+ */
+extern void SysExStart();
+extern void SysExConsume(uint8_t rx_byte);
+
+/**
+ * Handles the end of a message by F7 or any other status byte. An incomplete record is
+ * discarded.
+ */
+extern void SysExEnd();
+
+/* [] END OF FILE */
@@ -42,14 +42,45 @@ enum GateType {
     GATE_TYPE_END,
 };
 
+enum PortamentMode {
+    PORTAMENT_OFF = 0,
+    PORTAMENT_ALWAYS,    // glide on every note change
+    PORTAMENT_LEGATO,    // glide only between overlapping notes
+    PORTAMENT_FINGERED,  // glide only on overlapping note-ons, jump back on releases
+    PORTAMENT_MODE_END,
+};
+
+enum PressureRoute {
+    PRESSURE_OFF = 0,        // forwarded to Analog3 only
+    PRESSURE_TO_EXPRESSION,
+    PRESSURE_TO_MODULATION,
+    PRESSURE_TO_VELOCITY,    // velocity DAC of the voice while the gate is on
+    PRESSURE_ROUTE_END,
+};
+
 typedef struct voice_config {
     void (*set_note)(uint8_t note_number);
     void (*gate_on)(uint8_t velocity);
     void (*gate_off)();
+    void (*set_portament)(uint8_t on);
+    void (*set_pressure)(uint8_t value);
 } voice_config_t;
 
 extern enum GateType gate_type;
+
+// Gate delay for the largest note interval in ms, to let the note CV settle
+#define DEFAULT_GATE_DELAY_MAX 10
+extern uint8_t gate_delay_max;
+
 extern void GetVoiceConfigs(voice_config_t voice_configs[], unsigned size);  // implemented in hardware.c
+
+/**
+ * The voice_config_t methods stage the output changes, which are committed together at
+ * the next timer tick. Hold the frame while changing multiple voices, so that the changes
+ * come out at the same tick.
+ */
+extern void HoldOutputFrame();
+extern void ReleaseOutputFrame();
 /**
  * Updates the gate_type to a new value.
  *
@@ -58,4 +89,23 @@ extern void GetVoiceConfigs(voice_config_t voice_configs[], unsigned size);  //
  */
 extern int8_t UpdateGateType(enum GateType new_gate_type);
 
+extern uint8_t pressure_route;
+
+extern enum PortamentMode portament_mode;
+/**
+ * Updates the portament_mode to a new value.
+ *
+ * @param new_portament_mode - New portament mode
+ * @param save - 1 to save the mode to EEPROM, 0 if the caller saves it by the write-back
+ * @returns 1 when the value has changed, 0 otherwise
+ */
+extern int8_t UpdatePortamentMode(enum PortamentMode new_portament_mode, uint8_t save);
+
+/**
+ * Returns the portament mode in effect, i.e., portament_mode overridden by the
+ * portament switch (CC65). Switch off disables portament. Switch on glides always
+ * if the mode is off.
+ */
+extern enum PortamentMode GetEffectivePortamentMode();
+
 /* [] END OF FILE */
@@ -0,0 +1,75 @@
+/*
+ * Host stand-in for the PSoC Creator generated project.h. Declares only what the
+ * firmware sources under test use; each test defines the functions it needs.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+typedef uint8_t uint8;
+typedef uint16_t uint16;
+typedef uint32_t uint32;
+
+void CyDelayUs(uint16_t microseconds);
+
+void Pin_Pot_UD_Write(uint8_t value);
+void Pin_Pot_Select_Note_1_Write(uint8_t value);
+void Pin_Pot_Select_Note_2_Write(uint8_t value);
+void Pin_Pot_Select_Portament_1_Write(uint8_t value);
+void Pin_Pot_Select_Portament_2_Write(uint8_t value);
+
+typedef uint32_t cystatus;
+#define CYRET_SUCCESS 0u
+#define CYRET_LOCKED 1u
+
+uint8_t CyEnterCriticalSection(void);
+void CyExitCriticalSection(uint8_t state);
+
+#define CY_SYS_SYST_CSR_CLK_SRC_LFCLK 1u
+void CySysTickInit(void);
+void CySysTickSetClockSource(uint32_t source);
+void CySysTickSetReload(uint32_t value);
+void CySysTickSetCallback(uint32_t number, void (*function)(void));
+void CySysTickEnableInterrupt(void);
+void CySysTickDisableInterrupt(void);
+void CySysTickClear(void);
+void CySysTickEnable(void);
+void CySysTickStop(void);
+
+uint8_t EEPROM_ReadByte(uint16_t address);
+cystatus EEPROM_WriteByte(uint8_t value, uint16_t address);
+
+void PWM_Bend_Start(void);
+void PWM_Bend_WriteCompare(uint16_t compare);
+void PWM_Notes_Start(void);
+void PWM_Notes_WriteCompare1(uint8_t compare);
+void PWM_Notes_WriteCompare2(uint8_t compare);
+void PWM_Indicators_Start(void);
+void PWM_Indicators_WriteCompare1(uint8_t compare);
+void PWM_Indicators_WriteCompare2(uint8_t compare);
+
+void DVDAC_Velocity_1_Start(void);
+void DVDAC_Velocity_1_SetValue(uint16_t value);
+void DVDAC_Velocity_2_Start(void);
+void DVDAC_Velocity_2_SetValue(uint16_t value);
+void DVDAC_Expression_Start(void);
+void DVDAC_Expression_SetValue(uint16_t value);
+void DVDAC_Modulation_Start(void);
+void DVDAC_Modulation_SetValue(uint16_t value);
+
+void Pin_Portament_En_Write(uint8_t value);
+void Pin_Gate_1_Write(uint8_t value);
+void Pin_Gate_2_Write(uint8_t value);
+void Pin_Adj_En_Write(uint8_t value);
+void Pin_Adj_S0_Write(uint8_t value);
+uint8_t Pin_Encoder_LED_1_Read(void);
+void Pin_Encoder_LED_1_Write(uint8_t value);
+uint8_t Pin_Encoder_LED_2_Read(void);
+void Pin_Encoder_LED_2_Write(uint8_t value);
+
+typedef struct {
+    uint8 byte[8u];
+} CAN_DATA_BYTES_MSG;
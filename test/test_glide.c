@@ -0,0 +1,187 @@
+/*
+ * Runs the digital glide of hardware.c on the host and checks that the ramp of the bend
+ * PWM is linear, lasts the glide time and lands on the note.
+ *
+ * A glide of N units takes N * GLIDE_TICKS_PER_UNIT ticks of BendHandleTick. Every tick
+ * the offset must stay within 2 LSB of Q16 of the straight line from the interval to 0.
+ */
+
+#include <math.h>
+#include <stdio.h>
+
+#include "hardware.c"
+
+// Components
+uint8_t CyEnterCriticalSection(void) { return 0; }
+void CyExitCriticalSection(uint8_t state) { (void)state; }
+void CySysTickInit(void) {}
+void CySysTickSetClockSource(uint32_t source) { (void)source; }
+void CySysTickSetReload(uint32_t value) { (void)value; }
+void CySysTickSetCallback(uint32_t number, void (*function)(void)) { (void)number; (void)function; }
+void CySysTickEnableInterrupt(void) {}
+void CySysTickDisableInterrupt(void) {}
+void CySysTickClear(void) {}
+void CySysTickEnable(void) {}
+void CySysTickStop(void) {}
+uint8_t EEPROM_ReadByte(uint16_t address) { (void)address; return 0; }
+cystatus EEPROM_WriteByte(uint8_t value, uint16_t address) { (void)value; (void)address; return CYRET_SUCCESS; }
+void PWM_Bend_Start(void) {}
+void PWM_Notes_Start(void) {}
+void PWM_Notes_WriteCompare1(uint8_t compare) { (void)compare; }
+void PWM_Notes_WriteCompare2(uint8_t compare) { (void)compare; }
+void PWM_Indicators_Start(void) {}
+void PWM_Indicators_WriteCompare1(uint8_t compare) { (void)compare; }
+void PWM_Indicators_WriteCompare2(uint8_t compare) { (void)compare; }
+void DVDAC_Velocity_1_Start(void) {}
+void DVDAC_Velocity_1_SetValue(uint16_t value) { (void)value; }
+void DVDAC_Velocity_2_Start(void) {}
+void DVDAC_Velocity_2_SetValue(uint16_t value) { (void)value; }
+void DVDAC_Expression_Start(void) {}
+void DVDAC_Expression_SetValue(uint16_t value) { (void)value; }
+void DVDAC_Modulation_Start(void) {}
+void DVDAC_Modulation_SetValue(uint16_t value) { (void)value; }
+void Pin_Portament_En_Write(uint8_t value) { (void)value; }
+void Pin_Gate_1_Write(uint8_t value) { (void)value; }
+void Pin_Gate_2_Write(uint8_t value) { (void)value; }
+void Pin_Adj_En_Write(uint8_t value) { (void)value; }
+void Pin_Adj_S0_Write(uint8_t value) { (void)value; }
+uint8_t Pin_Encoder_LED_1_Read(void) { return 0; }
+void Pin_Encoder_LED_1_Write(uint8_t value) { (void)value; }
+uint8_t Pin_Encoder_LED_2_Read(void) { return 0; }
+void Pin_Encoder_LED_2_Write(uint8_t value) { (void)value; }
+
+// Other modules
+volatile uint32_t timer_counter;
+uint16_t curve_tables[NUM_CURVES][CURVE_SIZE];
+uint8_t gate_outputs[NUM_VOICES];
+uint8_t envelope_mode;
+uint8_t lfo_wave;
+pot_t pot_note_1, pot_note_2, pot_portament_1, pot_portament_2;
+uint16_t CurveValue14(enum CurveId curve_id, uint16_t value) { (void)curve_id; return value; }
+void InitializeCurves() {}
+void InitializeClockGates() {}
+void InitializeEnvelopes() {}
+void EnvelopeGateOn(enum Voice voice, uint16_t peak) { (void)voice; (void)peak; }
+void EnvelopeGateOff(enum Voice voice) { (void)voice; }
+void InitializeLfo() {}
+uint8_t LfoHandleTick() { return 0; }
+uint16_t Load16(uint16_t address) { (void)address; return 0; }
+cystatus Save8(uint8_t data, uint16_t address) { (void)data; (void)address; return CYRET_SUCCESS; }
+uint8_t ReadEepromWithValueCheck(uint16 address, uint8_t max) { (void)address; (void)max; return 0; }
+uint8_t PotChangePlaceRequest(pot_t *pot, int8_t wiper_position) { (void)pot; (void)wiper_position; return 1; }
+uint8_t PotChangeRestorePositions(pot_t *const pots[NUM_POTS]) { (void)pots; return 1; }
+
+static uint16_t pwm_bend;
+
+void PWM_Bend_WriteCompare(uint16_t compare)
+{
+    pwm_bend = compare;
+}
+
+static voice_config_t voice_1;
+
+static void Reset()
+{
+    ResumeBendDriver();
+    voice_1.set_portament(0);
+    voice_1.set_note(60);
+    BendHandleTick();
+}
+
+/*
+ * Glides from the note plus the interval to the note and returns the number of failures.
+ */
+static int CheckGlide(uint8_t time, int8_t interval)
+{
+    Reset();
+    glide_time = time;
+    voice_1.set_note(60 + interval);
+    voice_1.set_portament(1);
+    voice_1.set_note(60);
+
+    double start = glide_offset;
+    uint32_t total = glide_ticks;
+    double max_deviation = 0;
+    uint32_t ticks = 0;
+    while (glide_ticks) {
+        BendHandleTick();
+        ++ticks;
+        double ideal = start * (double)(total - ticks) / total;
+        double deviation = fabs(glide_offset - ideal);
+        max_deviation = deviation > max_deviation ? deviation : max_deviation;
+    }
+
+    int failures = 0;
+    if (ticks != (uint32_t)time * GLIDE_TICKS_PER_UNIT) {
+        printf("glide %u by %d: %u ticks, expected %u\n",
+               time, interval, ticks, time * GLIDE_TICKS_PER_UNIT);
+        ++failures;
+    }
+    if (max_deviation > 2) {
+        printf("glide %u by %d: deviates %.1f LSB from the line\n", time, interval, max_deviation);
+        ++failures;
+    }
+    BendHandleTick();
+    if (glide_offset != 0 || pwm_bend != bend_offset) {
+        printf("glide %u by %d: ends at offset %d, PWM %u\n", time, interval, glide_offset, pwm_bend);
+        ++failures;
+    }
+    return failures;
+}
+
+/*
+ * Retargets a glide halfway and checks that the offset does not jump.
+ */
+static int CheckRetarget()
+{
+    Reset();
+    glide_time = 20;
+    voice_1.set_portament(1);
+    voice_1.set_note(72);
+    for (int i = 0; i < 20 * GLIDE_TICKS_PER_UNIT / 2; ++i) {
+        BendHandleTick();
+    }
+    // The note output moves by semitones, the glide offset makes up the difference
+    int32_t halftone = (int32_t)(bend_halftone_width << 10);
+    int32_t before = 72 * halftone + glide_offset;
+    voice_1.set_portament(1);  // the key assigner arms every note change
+    voice_1.set_note(67);
+    int32_t after = 67 * halftone + glide_offset;
+    if (before != after) {
+        printf("retarget: pitch jumps by %d LSB\n", after - before);
+        return 1;
+    }
+    while (glide_ticks) {
+        BendHandleTick();
+    }
+    if (glide_offset != 0) {
+        printf("retarget: ends at offset %d\n", glide_offset);
+        return 1;
+    }
+    return 0;
+}
+
+int main()
+{
+    bend_offset = 512;
+    bend_octave_width = 120;
+    bend_halftone_width = ((uint32_t)bend_octave_width << 6) / 12;
+    bend_depth = 2;
+    gate_outputs[VOICE_1] = GATE_OUTPUT_NOTE;
+    gate_outputs[VOICE_2] = GATE_OUTPUT_NOTE;
+    GetVoiceConfigs(&voice_1, 1);
+
+    static const uint8_t kTimes[] = { 1, 3, 10, 77, MAX_GLIDE_TIME };
+    static const int8_t kIntervals[] = { 1, -1, 7, -12, 24, -31 };
+    int failures = 0;
+    for (unsigned t = 0; t < sizeof(kTimes); ++t) {
+        for (unsigned i = 0; i < sizeof(kIntervals); ++i) {
+            failures += CheckGlide(kTimes[t], kIntervals[i]);
+        }
+    }
+    printf("glide: %u ramps checked\n", (unsigned)(sizeof(kTimes) * sizeof(kIntervals)));
+    failures += CheckRetarget();
+
+    printf("test_glide: %s\n", failures ? "FAILED" : "passed");
+    return failures != 0;
+}
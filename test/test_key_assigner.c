@@ -0,0 +1,187 @@
+/*
+ * Runs the gate timing of key_assigner.c on the host, tick by tick as the PWM_Bend
+ * interrupt does, and checks the gate edges of note changes inside the gate delay and
+ * the gate messages sent to Analog3.
+ */
+
+#include <stdio.h>
+
+#include "key_assigner.c"
+
+volatile uint32_t timer_counter;
+uint8_t gate_delay_max = DEFAULT_GATE_DELAY_MAX;
+static enum PortamentMode effective_portament_mode = PORTAMENT_OFF;
+
+uint8_t CyEnterCriticalSection(void) { return 0; }
+void CyExitCriticalSection(uint8_t state) { (void)state; }
+void HoldOutputFrame() {}
+void ReleaseOutputFrame() {}
+enum PortamentMode GetEffectivePortamentMode() { return effective_portament_mode; }
+
+#define MAX_EDGES 16
+
+typedef struct edge {
+    uint8_t gate;
+    uint32_t time;
+} edge_t;
+
+static edge_t edges[MAX_EDGES];
+static int num_edges;
+
+static void RecordEdge(uint8_t gate)
+{
+    if (num_edges < MAX_EDGES) {
+        edges[num_edges].gate = gate;
+        edges[num_edges].time = timer_counter;
+    }
+    ++num_edges;
+}
+
+static void RecordGateOn(uint8_t velocity) { (void)velocity; RecordEdge(1); }
+static void RecordGateOff() { RecordEdge(0); }
+static void IgnoreNote(uint8_t note_number) { (void)note_number; }
+static void IgnorePortament(uint8_t on) { (void)on; }
+static void IgnorePressure(uint8_t value) { (void)value; }
+
+void GetVoiceConfigs(voice_config_t voice_configs[], unsigned size)
+{
+    for (unsigned i = 0; i < size; ++i) {
+        voice_configs[i].set_note = IgnoreNote;
+        voice_configs[i].gate_on = RecordGateOn;
+        voice_configs[i].gate_off = RecordGateOff;
+        voice_configs[i].set_portament = IgnorePortament;
+        voice_configs[i].set_pressure = IgnorePressure;
+    }
+}
+
+#define MAX_MESSAGES 16
+
+static CAN_DATA_BYTES_MSG messages[MAX_MESSAGES];
+static int num_messages;
+
+void A3SendDataStandard(uint32_t id, uint8_t dlc, CAN_DATA_BYTES_MSG *data)
+{
+    (void)dlc;
+    if (id != A3_ID_MIDI_VOICE_BASE + VOICE_1 ||
+        (data->byte[0] != A3_VOICE_MSG_GATE_ON && data->byte[0] != A3_VOICE_MSG_GATE_OFF)) {
+        return;
+    }
+    if (num_messages < MAX_MESSAGES) {
+        messages[num_messages] = *data;
+    }
+    ++num_messages;
+}
+
+static key_assigner_t assigner;
+
+static void Run(uint32_t ticks)
+{
+    while (ticks--) {
+        ++timer_counter;
+        KeyAssigner_HandleTick();
+    }
+}
+
+static void Reset()
+{
+    timer_counter = 0xfffffc00u;  // the edges under test cross the counter wrap
+    KeyAssigner_ConnectVoices();
+    InitializeKeyAssigner(&assigner, KEY_PRIORITY_LATER);
+    AddVoice(&assigner, &all_voices[VOICE_1], KEY_ASSIGN_DUOPHONIC);
+    NoteOn(&assigner, 60, 100);
+    Run(1000);
+    KeyAssigner_NotifyGates();
+    num_edges = 0;
+    num_messages = 0;
+}
+
+/*
+ * Checks the recorded edges against the expected gate levels, each edge at least a tick
+ * after the previous one. Returns the number of failures.
+ */
+static int CheckEdges(const char *name, const uint8_t *gates, int count)
+{
+    int failures = num_edges != count;
+    for (int i = 0; !failures && i < count; ++i) {
+        failures += edges[i].gate != gates[i];
+        failures += i > 0 && (int32_t)(edges[i].time - edges[i - 1].time) < 1;
+    }
+    printf("%s: %d edges%s\n", name, num_edges, failures ? ", FAILED" : "");
+    for (int i = 0; failures && i < num_edges && i < MAX_EDGES; ++i) {
+        printf("  %s at %u\n", edges[i].gate ? "on" : "off", edges[i].time);
+    }
+    return failures != 0;
+}
+
+int main()
+{
+    static const uint8_t kRetrigger[] = { 0, 1 };
+    static const uint8_t kLegato[] = { 1 };  // the velocity of the new note, no gate-off
+    int failures = 0;
+
+    // The same note struck again while its gate-off waits: the short gate delay of the
+    // unison interval would place the new gate-on before the pending gate-off
+    Reset();
+    NoteOff(&assigner, 60);
+    Run(100);
+    NoteOn(&assigner, 60, 100);
+    Run(1000);
+    failures += CheckEdges("re-strike the same note", kRetrigger, 2);
+
+    // Another note struck while the gate-off waits, its gate-on due after the gate-off
+    Reset();
+    NoteOff(&assigner, 60);
+    Run(400);
+    NoteOn(&assigner, 61, 100);
+    Run(1000);
+    failures += CheckEdges("strike the next note", kRetrigger, 2);
+
+    // Struck just before the gate-off fires
+    Reset();
+    NoteOff(&assigner, 60);
+    Run(GATE_DELAY_TICKS_PER_MS * DEFAULT_GATE_DELAY_MAX - 1);
+    NoteOn(&assigner, 72, 100);
+    Run(1000);
+    failures += CheckEdges("strike at the gate-off", kRetrigger, 2);
+
+    // Legato keeps the gate on
+    Reset();
+    NoteOn(&assigner, 62, 100);
+    Run(100);
+    NoteOff(&assigner, 60);
+    Run(1000);
+    failures += CheckEdges("legato", kLegato, 1);
+
+    // A short note fires both edges before the main loop sends them, and the next note
+    // changes the velocity in the mean time
+    Reset();
+    NoteOff(&assigner, 60);
+    Run(1000);
+    NoteOn(&assigner, 64, 90);
+    NoteOff(&assigner, 64);
+    Run(1000);
+    NoteOn(&assigner, 65, 30);
+    KeyAssigner_NotifyGates();
+    int notify_failures = num_messages != 3 ||
+        messages[0].byte[0] != A3_VOICE_MSG_GATE_OFF ||
+        messages[1].byte[0] != A3_VOICE_MSG_GATE_ON || messages[1].byte[1] != 90 << 1 ||
+        messages[2].byte[0] != A3_VOICE_MSG_GATE_OFF;
+    printf("notify a short note: %d messages%s\n", num_messages, notify_failures ? ", FAILED" : "");
+    failures += notify_failures;
+
+    // Only the sounding note routes the poly key pressure, not the hidden held notes
+    Reset();
+    NoteOn(&assigner, 64, 100);
+    Run(1000);
+    int sounding_failures = !IsNoteSounding(&assigner, &all_voices[VOICE_1], 64) ||
+        IsNoteSounding(&assigner, &all_voices[VOICE_1], 60) ||
+        IsNoteSounding(&assigner, &all_voices[VOICE_2], 64);
+    NoteOff(&assigner, 64);
+    NoteOff(&assigner, 60);
+    sounding_failures += IsNoteSounding(&assigner, &all_voices[VOICE_1], 64);
+    printf("sounding note: %s\n", sounding_failures ? "FAILED" : "checked");
+    failures += sounding_failures != 0;
+
+    printf("test_key_assigner: %s\n", failures ? "FAILED" : "passed");
+    return failures != 0;
+}
@@ -0,0 +1,110 @@
+/*
+ * Replays a MIDI clock through midi_clock.c on the host and reports the jitter of the
+ * clocks forwarded to Analog3 and the tempo estimate.
+ *
+ * The clock arrives at 120 BPM, then 140 BPM, with up to 3 ticks of service jitter, and
+ * crosses the timer counter wrap. Each clock must be forwarded at the tick it is handled,
+ * and the estimate must hold the tempo within 0.05 BPM once settled.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "midi_clock.c"
+
+#define TICK_SECONDS 21.354e-6
+#define SETTLE_CLOCKS 200
+#define MAX_TEMPO_ERROR 5  // 1/100 BPM
+
+volatile uint32_t timer_counter;
+
+static uint32_t sent_clocks;
+static uint32_t forward_time;
+static uint32_t late_forwards;
+
+void A3SendDataStandard(uint32_t id, uint8_t dlc, CAN_DATA_BYTES_MSG *data)
+{
+    (void)dlc;
+    (void)data;
+    if (id != A3_ID_MIDI_TIMING_CLOCK) {
+        return;
+    }
+    ++sent_clocks;
+    forward_time = timer_counter;
+    if (midi_clock.num_clocks && midi_clock.last_time == timer_counter) {
+        // the clock has been tracked before it is forwarded
+        ++late_forwards;
+    }
+}
+
+void ClockGateHandleClock(uint32_t index, uint32_t now) { (void)index; (void)now; }
+void ClockGateHandleStart(uint32_t now) { (void)now; }
+void ClockGateHandleStop() {}
+void LfoHandleClock(uint32_t index) { (void)index; }
+
+int main()
+{
+    static const double kTempos[] = { 120, 140 };
+    const int clocks_per_tempo = 2000;
+    int failures = 0;
+
+    srand(1);
+    timer_counter = 0xfffff000u;  // wraps during the first tempo
+    InitializeMidiClock();
+    HandleMidiRealTime(MSG_START);
+
+    double t = timer_counter;
+    uint32_t last_forward = 0;
+    for (unsigned k = 0; k < sizeof(kTempos) / sizeof(kTempos[0]); ++k) {
+        double period = 60.0 / (kTempos[k] * MIDI_CLOCKS_PER_BEAT) / TICK_SECONDS;
+        double jitter_max = 0;
+        double jitter_sum = 0;
+        int tempo_error_max = 0;
+        int unlocked = 0;
+        for (int i = 0; i < clocks_per_tempo; ++i) {
+            t += period;
+            timer_counter = (uint32_t)(int64_t)t + (rand() % 7) - 3;
+            HandleMidiRealTime(MSG_TIMING_CLOCK);
+            if (forward_time != timer_counter) {
+                ++late_forwards;
+            }
+            if (i > 0 || k > 0) {
+                double jitter = fabs((double)(uint32_t)(forward_time - last_forward) - period);
+                jitter_max = jitter > jitter_max ? jitter : jitter_max;
+                jitter_sum += jitter;
+            }
+            last_forward = forward_time;
+            if (i >= SETTLE_CLOCKS) {
+                int error = abs((int)GetMidiClockTempo() - (int)lround(kTempos[k] * 100));
+                tempo_error_max = error > tempo_error_max ? error : tempo_error_max;
+                unlocked += !midi_clock.locked;
+            }
+        }
+        printf("%.0f BPM: forwarded jitter mean %.2f max %.2f ticks (%.1fus), "
+               "tempo %u/100 BPM, max error %d/100 BPM\n",
+               kTempos[k], jitter_sum / clocks_per_tempo, jitter_max, jitter_max * TICK_SECONDS * 1e6,
+               GetMidiClockTempo(), tempo_error_max);
+        if (tempo_error_max > MAX_TEMPO_ERROR || unlocked) {
+            printf("%.0f BPM: tempo not held\n", kTempos[k]);
+            ++failures;
+        }
+        // the period is fractional, so the interval rounds by up to 1 tick over the service jitter
+        if (jitter_max > 7) {
+            printf("%.0f BPM: forwarded clocks jitter more than the service\n", kTempos[k]);
+            ++failures;
+        }
+    }
+
+    if (late_forwards) {
+        printf("%u clocks forwarded late\n", late_forwards);
+        ++failures;
+    }
+    if (sent_clocks != midi_clock.count) {
+        printf("%u clocks forwarded, %u counted\n", sent_clocks, midi_clock.count);
+        ++failures;
+    }
+
+    printf("test_midi_clock: %s\n", failures ? "FAILED" : "passed");
+    return failures != 0;
+}
@@ -0,0 +1,154 @@
+/*
+ * Simulates four MCP4011 devices on the shared U/D line and checks that the grouped
+ * stepping of pot.c lands every wiper on its target.
+ *
+ * Device model (data sheet DS20001978): the U/D level at the falling edge of CS selects
+ * the increment or the decrement mode, and each rising edge of U/D while CS is low moves
+ * the wiper one step in that mode, saturating at 0 and 63.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "pot.c"
+
+typedef struct device {
+    uint8_t cs;
+    uint8_t up;
+    int wiper;
+} device_t;
+
+static device_t devices[NUM_POTS];
+static uint8_t ud_level;
+static unsigned long pulses;
+
+static void WriteSelect(enum PotId id, uint8_t value)
+{
+    device_t *device = &devices[id];
+    if (device->cs && !value) {
+        device->up = ud_level;
+    }
+    device->cs = value;
+}
+
+void Pin_Pot_Select_Note_1_Write(uint8_t value) { WriteSelect(POT_NOTE_1, value); }
+void Pin_Pot_Select_Note_2_Write(uint8_t value) { WriteSelect(POT_NOTE_2, value); }
+void Pin_Pot_Select_Portament_1_Write(uint8_t value) { WriteSelect(POT_PORTAMENT_1, value); }
+void Pin_Pot_Select_Portament_2_Write(uint8_t value) { WriteSelect(POT_PORTAMENT_2, value); }
+
+void Pin_Pot_UD_Write(uint8_t value)
+{
+    if (!ud_level && value) {
+        ++pulses;
+        for (int i = 0; i < NUM_POTS; ++i) {
+            device_t *device = &devices[i];
+            if (device->cs) {
+                continue;
+            }
+            device->wiper += device->up ? 1 : -1;
+            device->wiper = device->wiper < 0 ? 0 : device->wiper > 63 ? 63 : device->wiper;
+        }
+    }
+    ud_level = value;
+}
+
+void CyDelayUs(uint16_t microseconds)
+{
+    (void)microseconds;
+}
+
+static void PowerUp()
+{
+    ud_level = 0;
+    for (int i = 0; i < NUM_POTS; ++i) {
+        devices[i].cs = 1;
+        devices[i].up = 0;
+        devices[i].wiper = 0x1f;  // the power-on default
+    }
+    PotGlobalInit();
+}
+
+/**
+ * Calls PotUpdateAll() as the interrupt handler does until all pots are idle.
+ *
+ * @returns the number of calls, -1 if it does not complete
+ */
+static long RunToIdle()
+{
+    for (long calls = 1; calls < 100000; ++calls) {
+        if (PotUpdateAll()) {
+            return calls;
+        }
+    }
+    return -1;
+}
+
+static int CheckWipers(const char *name)
+{
+    int failures = 0;
+    for (int i = 0; i < NUM_POTS; ++i) {
+        pot_t *pot = all_pots[i];
+        if (pot->current != pot->target || devices[i].wiper != pot->target || !devices[i].cs) {
+            printf("%s: pot %d current %d target %d wiper %d cs %d\n",
+                   name, i, pot->current, pot->target, devices[i].wiper, devices[i].cs);
+            ++failures;
+        }
+    }
+    return failures;
+}
+
+int main()
+{
+    int failures = 0;
+    srand(1);
+
+    // Homing from unknown positions: all pots down to 0 together
+    PowerUp();
+    for (int i = 0; i < NUM_POTS; ++i) {
+        devices[i].wiper = rand() % 64;
+        PotEnsureToMoveToB(all_pots[i]);
+    }
+    pulses = 0;
+    if (RunToIdle() < 0) {
+        printf("homing: did not complete\n");
+        ++failures;
+    }
+    failures += CheckWipers("homing");
+    printf("homing: %lu pulses for 4 pots (sequential: %d)\n", pulses, 4 * 63);
+
+    // Random seeks, some retargeted while moving
+    unsigned long total_pulses = 0;
+    unsigned long total_distance = 0;
+    for (int round = 0; round < 10000; ++round) {
+        for (int i = 0; i < NUM_POTS; ++i) {
+            int target = rand() % 64;
+            total_distance += abs(target - all_pots[i]->current);
+            PotSetTargetPosition(all_pots[i], target);
+        }
+        pulses = 0;
+        if (round % 3 == 0) {
+            for (int k = rand() % 40; k > 0; --k) {
+                PotUpdateAll();
+            }
+            for (int i = 0; i < NUM_POTS; ++i) {
+                if (rand() % 2) {
+                    PotSetTargetPosition(all_pots[i], rand() % 64);
+                }
+            }
+        }
+        if (RunToIdle() < 0) {
+            printf("round %d: did not complete\n", round);
+            ++failures;
+            break;
+        }
+        total_pulses += pulses;
+        failures += CheckWipers("seek");
+        if (failures > 10) {
+            break;
+        }
+    }
+    printf("seek: %lu pulses for %lu steps of distance\n", total_pulses, total_distance);
+
+    printf("test_pot: %s\n", failures ? "FAILED" : "passed");
+    return failures != 0;
+}